@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "allocator.h"
+#include "globals.h"
+
+static const char *kindNames[NUM_OF_ALLOC_KINDS] = {
+    "names", "macros", "code image", "data image", "fixups", "source", "arena", "output", "externals"
+};
+
+const char *allocationKindName(int kind) {
+    return kindNames[kind];
+}
+
+// Moves counters from oldSize to newSize bytes
+static void updateCounters(AllocationCounters *counters, long oldSize, long newSize) {
+    if (newSize > 0) {
+        counters->count++;
+        counters->bytes += newSize;
+    }
+    counters->live += newSize - oldSize;
+    if (counters->live > counters->peak) {
+        counters->peak = counters->live;
+    }
+}
+
+/**
+ * @brief Counts an allocation, resize or free of the current file.
+ *
+ * The size change is charged to the data structure and to the phase that is running.
+ * The phase's live and peak are those of the whole file while the phase runs.
+ * Does nothing without --memory, or outside of a file.
+ */
+void countAllocation(size_t oldSize, size_t newSize, int kind) {
+    if (context == NULL || context->stats == NULL || !context->stats->trackAllocations) {
+        return;
+    }
+    FileStats *stats = context->stats;
+
+    updateCounters(&stats->allocations[kind], (long)oldSize, (long)newSize);
+    updateCounters(&stats->totalAllocations, (long)oldSize, (long)newSize);
+
+    AllocationCounters *phase = &stats->phaseAllocations[stats->phase];
+    if (newSize > 0) {
+        phase->count++;
+        phase->bytes += (long)newSize;
+    }
+    phase->live = stats->totalAllocations.live;
+    if (phase->live > phase->peak) {
+        phase->peak = phase->live;
+    }
+}
+
+// Counts an allocation taken from the arena, the block it comes from is counted as ALLOC_ARENA
+void countArenaAllocation(size_t size, int kind) {
+    if (context == NULL || context->stats == NULL || !context->stats->trackAllocations) {
+        return;
+    }
+    context->stats->arenaAllocations[kind].count++;
+    context->stats->arenaAllocations[kind].bytes += (long)size;
+}
+
+void *trackedRealloc(void *pointer, size_t oldSize, size_t newSize, int kind) {
+    void *block = NULL;
+
+    if (newSize == 0) {
+        free(pointer);
+    } else {
+        block = realloc(pointer, newSize);
+        if (block == NULL) {
+            fprintf(context != NULL ? context->output : stdout, "Memory allocation error!\n");
+            exit(1);
+        }
+    }
+    countAllocation(oldSize, newSize, kind);
+    return block;
+}
+
+// Counts memory the file starts with, such as the arena block kept from the previous file
+void chargeRetainedMemory(size_t bytes, int kind) {
+    if (context == NULL || context->stats == NULL || !context->stats->trackAllocations) {
+        return;
+    }
+    FileStats *stats = context->stats;
+    stats->allocations[kind].live += (long)bytes;
+    stats->allocations[kind].peak = stats->allocations[kind].live;
+    stats->totalAllocations.live += (long)bytes;
+    stats->totalAllocations.peak = stats->totalAllocations.live;
+}
+
+/**
+ * @brief Reports the data structures that still hold memory once the file is cleaned up.
+ *
+ * Only the arena block kept for the next file may remain.
+ */
+void checkAllocations(size_t retainedArenaBytes) {
+    if (context == NULL || context->stats == NULL || !context->stats->trackAllocations) {
+        return;
+    }
+    for (int kind = 0; kind < NUM_OF_ALLOC_KINDS; kind++) {
+        long expected = (kind == ALLOC_ARENA) ? (long)retainedArenaBytes : 0;
+        long leaked = context->stats->allocations[kind].live - expected;
+        if (leaked != 0) {
+            fprintf(context->output, "Warning: %ld bytes of the %s were not freed by cleanupAssembler.\n",
+                    leaked, kindNames[kind]);
+        }
+    }
+}
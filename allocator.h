@@ -0,0 +1,40 @@
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+#include <stddef.h>
+
+// Data structures the allocations of a file are charged to (--memory)
+#define ALLOC_NAMES 0    // Name pool, symbol index and entry list
+#define ALLOC_MACROS 1   // Macro index
+#define ALLOC_CODE 2     // Code image and its placeholder bitmap
+#define ALLOC_DATA 3     // Data image
+#define ALLOC_FIXUPS 4   // Fixups and deferred .entry lines (single-pass mode)
+#define ALLOC_SOURCE 5   // Source read into memory and the expanded source
+#define ALLOC_ARENA 6    // Arena blocks, the allocations in them are charged to the other kinds
+#define ALLOC_OUTPUT 7   // Binary object image
+#define ALLOC_EXTERNALS 8  // External references and the labels of .extern lines (arena)
+#define NUM_OF_ALLOC_KINDS 9
+
+// Allocation counters of a data structure or a phase
+typedef struct AllocationCounters {
+    long count;   // Allocations and reallocations
+    long bytes;   // Bytes requested by them
+    long live;    // Bytes allocated and not freed yet
+    long peak;    // Highest value of live
+} AllocationCounters;
+
+// The single allocation entry point of the per-file data structures. Allocates
+// (pointer NULL), resizes or frees (newSize 0) a block, exits on allocation failure.
+// The caller passes the block's current size, so nothing is stored next to the block.
+// The sizes are counted in the file's statistics when --memory is on
+void *trackedRealloc(void *pointer, size_t oldSize, size_t newSize, int kind);
+#define trackedAlloc(size, kind) trackedRealloc(NULL, 0, (size), (kind))
+#define trackedFree(pointer, size, kind) trackedRealloc((pointer), (size), 0, (kind))
+
+void countAllocation(size_t oldSize, size_t newSize, int kind);
+void countArenaAllocation(size_t size, int kind);
+void chargeRetainedMemory(size_t bytes, int kind);
+void checkAllocations(size_t retainedArenaBytes);
+const char *allocationKindName(int kind);
+
+#endif // ALLOCATOR_H
@@ -0,0 +1,150 @@
+#define _DEFAULT_SOURCE  // MAP_ANONYMOUS and MADV_HUGEPAGE are not part of POSIX
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "arena.h"
+#include "allocator.h"
+
+// Size of the block header, rounded so the first allocation is aligned
+#define BLOCK_HEADER_SIZE ((sizeof(ArenaBlock) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+// Returns the first usable byte of a block
+static char *blockData(ArenaBlock *block) {
+    return (char *)block + BLOCK_HEADER_SIZE;
+}
+
+/**
+ * @brief Gets a block with at least 'size' usable bytes.
+ *
+ * Large blocks are mapped and advised onto transparent huge pages, which saves TLB
+ * misses on very large inputs. Without huge page support they come from malloc.
+ */
+static ArenaBlock *newBlock(size_t size) {
+    ArenaBlock *block = NULL;
+    size_t total = BLOCK_HEADER_SIZE + size;
+
+#if ARENA_HUGE_PAGES && defined(MAP_ANONYMOUS) && defined(MADV_HUGEPAGE)
+    if (total >= ARENA_HUGE_BLOCK_SIZE) {
+        total = (total + ARENA_HUGE_BLOCK_SIZE - 1) & ~(size_t)(ARENA_HUGE_BLOCK_SIZE - 1);
+        void *memory = mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory != MAP_FAILED) {
+            madvise(memory, total, MADV_HUGEPAGE);  // Only a hint, ignored where THP is off
+            block = (ArenaBlock *)memory;
+            block->isMapped = 1;
+            countAllocation(0, total, ALLOC_ARENA);
+        }
+    }
+#endif
+    if (block == NULL) {
+        block = (ArenaBlock *)trackedAlloc(total, ALLOC_ARENA);
+        block->isMapped = 0;
+    }
+    block->size = total - BLOCK_HEADER_SIZE;
+    block->previous = NULL;
+    return block;
+}
+
+static void freeBlock(ArenaBlock *block) {
+    size_t total = BLOCK_HEADER_SIZE + block->size;
+
+#if ARENA_HUGE_PAGES && defined(MAP_ANONYMOUS) && defined(MADV_HUGEPAGE)
+    if (block->isMapped) {
+        munmap(block, total);
+        countAllocation(total, 0, ALLOC_ARENA);
+        return;
+    }
+#endif
+    trackedFree(block, total, ALLOC_ARENA);
+}
+
+void initArena(Arena *arena) {
+    arena->current = NULL;
+    arena->used = 0;
+    memset(arena->allocated, 0, sizeof(arena->allocated));
+}
+
+/**
+ * @brief Allocates 'size' bytes, aligned to ARENA_ALIGNMENT.
+ *
+ * The bytes are charged to the data structure 'kind' (ALLOC_* in allocator.h).
+ * The memory stays valid until the arena is reset or released past it.
+ * Exits on allocation failure, like the rest of the assembler.
+ */
+void *arenaAlloc(Arena *arena, size_t size, int kind) {
+    size_t aligned = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+
+    if (arena->current == NULL || arena->current->size - arena->used < aligned) {
+        size_t blockSize = (arena->current == NULL) ? ARENA_FIRST_BLOCK_SIZE : 2 * arena->current->size;
+        while (blockSize < aligned) {
+            blockSize *= 2;
+        }
+        ArenaBlock *block = newBlock(blockSize);
+        block->previous = arena->current;
+        arena->current = block;
+        arena->used = 0;
+    }
+
+    void *memory = blockData(arena->current) + arena->used;
+    arena->used += aligned;
+    arena->allocated[kind] += size;
+    countArenaAllocation(size, kind);
+    return memory;
+}
+
+// Copies a null-terminated string into the arena, charged to 'kind'
+char *arenaStrdup(Arena *arena, const char *text, int kind) {
+    size_t length = strlen(text) + 1;
+    return (char *)memcpy(arenaAlloc(arena, length, kind), text, length);
+}
+
+// Records the current position, for arenaRelease
+ArenaMark arenaMark(const Arena *arena) {
+    ArenaMark mark;
+    mark.block = arena->current;
+    mark.used = arena->used;
+    memcpy(mark.allocated, arena->allocated, sizeof(mark.allocated));
+    return mark;
+}
+
+// Drops everything allocated since 'mark' was taken, for short-lived strings
+void arenaRelease(Arena *arena, ArenaMark mark) {
+    while (arena->current != mark.block) {
+        ArenaBlock *previous = arena->current->previous;
+        freeBlock(arena->current);
+        arena->current = previous;
+    }
+    arena->used = mark.used;
+    memcpy(arena->allocated, mark.allocated, sizeof(arena->allocated));
+}
+
+// Drops every allocation at once. The newest (largest) block is kept, so the next
+// file assembled with this arena starts without allocating
+void resetArena(Arena *arena) {
+    if (arena->current == NULL) {
+        return;
+    }
+    ArenaBlock *block = arena->current->previous;
+    while (block != NULL) {
+        ArenaBlock *previous = block->previous;
+        freeBlock(block);
+        block = previous;
+    }
+    arena->current->previous = NULL;
+    arena->used = 0;
+    memset(arena->allocated, 0, sizeof(arena->allocated));
+}
+
+// Returns the bytes of the block resetArena keeps
+size_t arenaRetainedBytes(const Arena *arena) {
+    return (arena->current != NULL) ? BLOCK_HEADER_SIZE + arena->current->size : 0;
+}
+
+// Returns all the memory of the arena
+void freeArena(Arena *arena) {
+    resetArena(arena);
+    if (arena->current != NULL) {
+        freeBlock(arena->current);
+    }
+    initArena(arena);
+}
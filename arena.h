@@ -0,0 +1,47 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include "allocator.h"
+
+#define ARENA_FIRST_BLOCK_SIZE 65536       // Bytes in the first block, each new block doubles
+#define ARENA_ALIGNMENT 16                 // Every allocation starts on this boundary
+#define ARENA_HUGE_BLOCK_SIZE (2u << 20)   // Blocks this large are mapped on transparent huge pages
+
+// Set ARENA_HUGE_PAGES to 0 (e.g. -DARENA_HUGE_PAGES=0) to always take blocks from malloc
+#ifndef ARENA_HUGE_PAGES
+#define ARENA_HUGE_PAGES 1
+#endif
+
+// A chunk of memory handed out front to back
+typedef struct ArenaBlock {
+    struct ArenaBlock *previous;  // The block filled before this one
+    size_t size;                  // Bytes available after the header
+    int isMapped;                 // 1 if the block was mapped, 0 if it came from malloc
+} ArenaBlock;
+
+// Bump allocator for everything that lives until the file is assembled. Nothing is freed
+// on its own, resetArena drops it all at once and keeps the largest block for the next file
+typedef struct Arena {
+    ArenaBlock *current;  // The block allocations are taken from, NULL before the first one
+    size_t used;          // Bytes used in the current block
+    size_t allocated[NUM_OF_ALLOC_KINDS];  // Bytes requested per data structure since the last reset
+} Arena;
+
+// A position in an arena, to drop the temporary allocations made after it
+typedef struct ArenaMark {
+    ArenaBlock *block;
+    size_t used;
+    size_t allocated[NUM_OF_ALLOC_KINDS];
+} ArenaMark;
+
+void initArena(Arena *arena);
+void *arenaAlloc(Arena *arena, size_t size, int kind);
+char *arenaStrdup(Arena *arena, const char *text, int kind);
+ArenaMark arenaMark(const Arena *arena);
+void arenaRelease(Arena *arena, ArenaMark mark);
+void resetArena(Arena *arena);
+size_t arenaRetainedBytes(const Arena *arena);
+void freeArena(Arena *arena);
+
+#endif
@@ -0,0 +1,219 @@
+#include "assembler.h"
+#include "preAssembler.h"
+#include "firstPass.h"
+#include "secondPass.h"
+#include "bitUtils.h"
+#include "errors.h"
+#include "outputWriter.h"
+#include "objectFile.h"
+#include "stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Writes the object file content: the counts line, then the code and data words in address order
+void writeObject(FILE *stream) {
+    OutputBuffer buffer;
+    char header[32];
+
+    initOutputBuffer(&buffer, stream);
+
+    // Write the first line: instruction count and data count
+    int length = snprintf(header, sizeof(header), "%d %d\n", context->ICF - 100, context->IDF);
+    appendText(&buffer, header, (size_t)length);
+
+    // Write the instructions, the code image is already in address order
+    int address = CODE_START_ADDRESS;
+    for (int i = 0; i < context->codeImage.count; i++) {
+        appendObjectLine(&buffer, address++, context->codeImage.words[i]);
+    }
+
+    // Write the data
+    for (int i = 0; i < context->dataImage.count; i++) {
+        appendObjectLine(&buffer, address++, context->dataImage.words[i]);
+    }
+
+    flushOutputBuffer(&buffer);
+}
+
+// Writes the entry symbols and their values, returns the number of entries written
+int writeEntries(FILE *stream) {
+    OutputBuffer buffer;
+
+    // The entry list holds just the entry symbols, in the order of the .entry lines
+    initOutputBuffer(&buffer, stream);
+    for (int i = 0; i < context->entryList.count; i++) {
+        Symbol *symbol = context->entryList.symbols[i];
+        appendSymbolLine(&buffer, nameText(symbol->name), symbol->value);
+    }
+
+    flushOutputBuffer(&buffer);
+    return context->entryList.count;
+}
+
+// Writes each external reference and the address where it is used
+void writeExternals(FILE *stream) {
+    ExternalReference *current = context->externalReferencesList;
+    OutputBuffer buffer;
+
+    initOutputBuffer(&buffer, stream);
+    while (current != NULL) {
+        appendSymbolLine(&buffer, nameText(current->symbol), current->address);
+        current = current->next;  // Move to the next external reference
+    }
+
+    flushOutputBuffer(&buffer);
+}
+
+int runPasses(const char *sourceName) {
+    // Step 6: Run the first pass using the output of the pre-assembler
+    logMessage(LOG_INFO, LOG_DRIVER, "Running the first pass on %s...\n", sourceName);
+    startPhase(PHASE_FIRST);
+    int firstPassSucceeded = firstPass(&context->expandedSource);
+    endPhase(PHASE_FIRST);
+    if (!firstPassSucceeded) {
+        fprintf(context->output, "First pass failed for %s.\n", sourceName);
+        return 0;
+    }
+
+    logMessage(LOG_INFO, LOG_DRIVER, "First pass completed successfully for %s.\n", sourceName);
+    printInstructionList();
+    printDataList();
+
+    // Step 7: Run the second pass, or patch the recorded fixups in single-pass mode
+    startPhase(PHASE_SECOND);
+    if (context->singlePassMode) {
+        logMessage(LOG_INFO, LOG_DRIVER, "Resolving %d fixups for %s...\n", context->fixupList.count, sourceName);
+        resolveFixups();
+    } else {
+        logMessage(LOG_INFO, LOG_DRIVER, "Running the second pass on %s...\n", sourceName);
+        secondPass(&context->expandedSource);
+    }
+    endPhase(PHASE_SECOND);
+
+    if (context->foundError) {
+        fprintf(context->output, "Second pass failed for %s.\n", sourceName);
+        return 0;
+    }
+
+    logMessage(LOG_INFO, LOG_DRIVER, "Second pass completed successfully for %s.\n", sourceName);
+    printInstructionList();
+    printDataList();
+    printSymbolTableStats();
+    return 1;
+}
+
+// Opens a memory stream, exits on allocation failure like the rest of the assembler
+static FILE *openBuffer(char **buffer, size_t *size) {
+    FILE *stream = open_memstream(buffer, size);
+    if (stream == NULL) {
+        fprintf(stderr, "Memory allocation error!\n");
+        exit(1);
+    }
+    return stream;
+}
+
+int assembleSource(const char *source, size_t length, int singlePassMode, AssemblyResult *result) {
+    AssemblerContext fileContext;
+    Arena arena;
+    AssemblerContext *callerContext = context;  // Restored on return, in case the caller is assembling too
+    FILE *diagnostics;
+
+    memset(result, 0, sizeof(AssemblyResult));
+    diagnostics = openBuffer(&result->diagnostics, &result->diagnosticsSize);
+
+    initArena(&arena);
+    initAssemblerContext(&fileContext, diagnostics, &arena, singlePassMode, 0);
+    context = &fileContext;
+
+    if (preAssembleBuffer(source, length) && runPasses("source")) {
+        FILE *object = openBuffer(&result->object, &result->objectSize);
+        FILE *entries = openBuffer(&result->entries, &result->entriesSize);
+        FILE *externals = openBuffer(&result->externals, &result->externalsSize);
+        FILE *binaryObject = openBuffer(&result->binaryObject, &result->binaryObjectSize);
+
+        writeObject(object);
+        writeEntries(entries);
+        writeExternals(externals);
+        writeBinaryObject(binaryObject);
+
+        fclose(object);
+        fclose(entries);
+        fclose(externals);
+        fclose(binaryObject);
+        result->succeeded = 1;
+    }
+
+    cleanupAssembler();
+    freeArena(&arena);
+    context = callerContext;
+    fclose(diagnostics);
+    return result->succeeded;
+}
+
+void freeAssemblyResult(AssemblyResult *result) {
+    free(result->object);
+    free(result->entries);
+    free(result->externals);
+    free(result->binaryObject);
+    free(result->diagnostics);
+    memset(result, 0, sizeof(AssemblyResult));
+}
+
+// Check if there are any entry symbols in the symbol table
+int hasEntrySymbols() {
+    return context->entryList.count > 0;
+}
+
+// Check if there are any external references in the external references list
+int hasExternalReferences() {
+    ExternalReference *current = context->externalReferencesList;  // Start with the head of the external references list
+
+    // Traverse the external references list
+    while (current != NULL) {
+        return 1;  // As soon as we find an external reference, return 1
+        current = current->next;
+    }
+
+    return 0;  // No external references found
+}
+
+// Function to clean up the assembler's data structures
+void cleanupAssembler() {
+    // Keep the counters of the tables for --stats before they go
+    if (context->stats != NULL) {
+        collectFileStats(context->stats);
+    }
+
+    // Free the symbol table, its index and the name pool
+    freeSymbolTable();
+    freeEntryList();
+    freeNamePool();
+
+    // Free the macro table and its hash index
+    freeMacroTable();
+
+    // Free the instruction image
+    freeCodeImage();
+
+    // Free the data image
+    freeDataImage();
+
+    // Free the single-pass fixups
+    freeFixupList();
+    freeSourceBuffer(&context->expandedSource);
+
+    // Drop the symbols, macros, external references and strings of the file at once
+    context->externalReferencesList = NULL;
+    context->externalReferencesTail = NULL;
+    resetArena(context->arena);
+
+    // With --memory, only the arena block kept for the next file may still be allocated
+    checkAllocations(arenaRetainedBytes(context->arena));
+
+    // Reset error flag, data counter (DC), and instruction counter (IC)
+    context->foundError = 0;
+    context->DC = 0;
+    context->IC = 0;
+    context->counter = 0;
+}
@@ -0,0 +1,50 @@
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "globals.h"
+
+// The output of assembling one source buffer. Every buffer is null-terminated and
+// owned by the result, release them with freeAssemblyResult
+typedef struct AssemblyResult {
+    char *object;             // Content of the .ob file
+    size_t objectSize;
+    char *entries;            // Content of the .ent file, empty if there are no entry symbols
+    size_t entriesSize;
+    char *externals;          // Content of the .ext file, empty if there are no external references
+    size_t externalsSize;
+    char *binaryObject;       // Content of the binary object file (see objectFile.h)
+    size_t binaryObjectSize;
+    char *diagnostics;        // The messages printed while assembling
+    size_t diagnosticsSize;
+    int succeeded;            // 1 if the source was assembled without errors
+} AssemblyResult;
+
+// Library entry point: assembles a source held in memory into memory buffers.
+// Nothing is read from or written to the filesystem and no state is shared between
+// calls, so different threads may assemble at the same time. Returns result->succeeded
+int assembleSource(const char *source, size_t length, int singlePassMode, AssemblyResult *result);
+
+// Frees the buffers of an assembly result
+void freeAssemblyResult(AssemblyResult *result);
+
+// Runs the first pass and the second pass (or the fixups) over the expanded source,
+// printing progress about sourceName. Returns 1 if no errors were found
+int runPasses(const char *sourceName);
+
+// Function to check if any entry symbols exist in the symbol table
+int hasEntrySymbols();
+
+// Function to check if there are any external references in the external reference list
+int hasExternalReferences();
+
+// Functions to write the object, entry and external file contents to a stream
+void writeObject(FILE *stream);
+int writeEntries(FILE *stream);
+void writeExternals(FILE *stream);
+
+// Function to clean up the assembler's data structures
+void cleanupAssembler();
+
+#endif // ASSEMBLER_H
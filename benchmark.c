@@ -0,0 +1,248 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "benchmark.h"
+
+// The configurations run by default, each is the default workload with some settings changed
+static const BenchmarkPreset presets[] = {
+    {"mixed-10k", 10000, ""},
+    {"mixed-100k", 100000, ""},
+    {"labels", 100000, "labels=60 forward=50"},
+    {"forward", 100000, "forward=90"},
+    {"macros", 100000, "macros=200 macro-lines=20 macro-calls=25"},
+    {"data", 100000, "data=40 data-values=12 strings=20 string-length=40"},
+    {"externs", 100000, "externs=2000 extern-refs=40 entries=5000"},
+    {NULL, 0, NULL}
+};
+
+// Builds the configuration of a preset
+int presetConfig(const BenchmarkPreset *preset, WorkloadConfig *config) {
+    char settings[256];
+
+    defaultWorkloadConfig(config, preset->name, preset->lines);
+    snprintf(settings, sizeof(settings), "%s", preset->settings);
+    for (char *setting = strtok(settings, " "); setting != NULL; setting = strtok(NULL, " ")) {
+        if (!parseWorkloadSetting(config, setting)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Reads the results saved by --save. Returns the number of entries read
+int readBaseline(const char *fileName, BenchmarkResult *baseline, int maxEntries) {
+    char line[256];
+    int count = 0;
+
+    FILE *stream = fopen(fileName, "r");
+    if (stream == NULL) {
+        return 0;
+    }
+    while (count < maxEntries && fgets(line, sizeof(line), stream) != NULL) {
+        BenchmarkResult *entry = &baseline[count];
+        if (line[0] == '#') {
+            continue;  // Column names
+        }
+        if (sscanf(line, "%31s %lf %lf %ld", entry->name, &entry->linesPerSecond,
+                   &entry->wordsPerSecond, &entry->peakKb) == 4) {
+            count++;
+        }
+    }
+    fclose(stream);
+    return count;
+}
+
+// Returns the baseline entry of a configuration, NULL if it has none
+static const BenchmarkResult *findBaseline(const BenchmarkResult *baseline, int count, const char *name) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(baseline[i].name, name) == 0) {
+            return &baseline[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Generates the workload of a configuration and assembles it 'runs' times.
+ *
+ * The fastest run gives the throughput, the largest peak RSS is reported.
+ *
+ * @return int 1 if every run succeeded.
+ */
+int runBenchmark(const WorkloadConfig *config, const BenchmarkOptions *options, BenchmarkResult *result) {
+    char baseFile[256];
+    long sourceLines;
+    double bestSeconds = 0;
+
+    memset(result, 0, sizeof(BenchmarkResult));
+    snprintf(result->name, sizeof(result->name), "%s", config->name);
+    snprintf(baseFile, sizeof(baseFile), "%s/%s", options->directory, config->name);
+    if (!writeWorkload(config, baseFile, &sourceLines)) {
+        return 0;
+    }
+    result->lines = sourceLines;
+
+    for (int run = 0; run < options->runs; run++) {
+        RunResult measured;
+        if (!runAssembler(options->assembler, baseFile, &measured)) {
+            printf("Error: %s failed on %s.asm\n", options->assembler, baseFile);
+            return 0;
+        }
+        if (run == 0 || measured.wallSeconds < bestSeconds) {
+            bestSeconds = measured.wallSeconds;
+            result->cpuSeconds = measured.cpuSeconds;
+        }
+        if (measured.peakKb > result->peakKb) {
+            result->peakKb = measured.peakKb;
+        }
+        result->words = measured.words;
+    }
+
+    result->seconds = bestSeconds;
+    result->linesPerSecond = bestSeconds > 0 ? result->lines / bestSeconds : 0;
+    result->wordsPerSecond = bestSeconds > 0 ? result->words / bestSeconds : 0;
+    return 1;
+}
+
+// Prints one result, with its change from the baseline when there is one
+static void printResult(const BenchmarkResult *result, const BenchmarkResult *baseline) {
+    printf("%-12s %9ld %9ld %8.3f %8.3f %12.0f %12.0f %9ld", result->name, result->lines, result->words,
+           result->seconds, result->cpuSeconds, result->linesPerSecond, result->wordsPerSecond, result->peakKb);
+    if (baseline != NULL && baseline->linesPerSecond > 0 && baseline->peakKb > 0) {
+        printf("  %+6.1f%% lines/s %+6.1f%% RSS",
+               100.0 * (result->linesPerSecond / baseline->linesPerSecond - 1.0),
+               100.0 * ((double)result->peakKb / baseline->peakKb - 1.0));
+    }
+    printf("\n");
+}
+
+// Writes the results in the format read by readBaseline
+static int saveResults(const char *fileName, const BenchmarkResult *results, int count) {
+    FILE *stream = fopen(fileName, "w");
+    if (stream == NULL) {
+        printf("Error: Unable to create baseline file: %s\n", fileName);
+        return 0;
+    }
+    fprintf(stream, "# config lines/s words/s peak-kb\n");
+    for (int i = 0; i < count; i++) {
+        fprintf(stream, "%s %.0f %.0f %ld\n", results[i].name, results[i].linesPerSecond,
+                results[i].wordsPerSecond, results[i].peakKb);
+    }
+    fclose(stream);
+    return 1;
+}
+
+static void printUsage(const char *program) {
+    printf("Usage: %s [--assembler PATH] [--dir DIR] [--runs N] [--baseline FILE] [--save FILE] [PRESET...] [KEY=VALUE...]\n"
+           "       %s --generate BASE [KEY=VALUE...]\n"
+           "Presets:", program, program);
+    for (int i = 0; presets[i].name != NULL; i++) {
+        printf(" %s", presets[i].name);
+    }
+    printf("\nKeys: lines labels forward macros macro-lines macro-calls data data-values strings\n"
+           "      string-length externs extern-refs entries seed (percentages are of the body lines)\n");
+}
+
+// Generates workloads and reports the assembler's throughput and peak memory on each of them
+int main(int argc, char *argv[]) {
+    BenchmarkOptions options;
+    WorkloadConfig configs[MAX_BENCHMARKS];
+    BenchmarkResult results[MAX_BENCHMARKS];
+    BenchmarkResult baseline[MAX_BENCHMARKS];
+    WorkloadConfig custom;
+    const char *generateBase = NULL;
+    int numOfConfigs = 0, hasCustom = 0, baselineCount = 0, failed = 0;
+
+    options.assembler = "./assembler";
+    options.directory = "bench_workloads";
+    options.runs = 3;
+    options.baselineFile = NULL;
+    options.saveFile = NULL;
+    defaultWorkloadConfig(&custom, "custom", 10000);
+
+    for (int i = 1; i < argc; i++) {
+        int hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--assembler") == 0 && hasValue) {
+            options.assembler = argv[++i];
+        } else if (strcmp(argv[i], "--dir") == 0 && hasValue) {
+            options.directory = argv[++i];
+        } else if (strcmp(argv[i], "--runs") == 0 && hasValue) {
+            options.runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--baseline") == 0 && hasValue) {
+            options.baselineFile = argv[++i];
+        } else if (strcmp(argv[i], "--save") == 0 && hasValue) {
+            options.saveFile = argv[++i];
+        } else if (strcmp(argv[i], "--generate") == 0 && hasValue) {
+            generateBase = argv[++i];
+        } else if (strchr(argv[i], '=') != NULL) {
+            if (!parseWorkloadSetting(&custom, argv[i])) {
+                printf("Error: Bad workload setting '%s'.\n", argv[i]);
+                return 1;
+            }
+            hasCustom = 1;
+        } else {
+            int found = 0;
+            for (int p = 0; presets[p].name != NULL && !found; p++) {
+                if (strcmp(argv[i], presets[p].name) == 0 && numOfConfigs < MAX_BENCHMARKS) {
+                    presetConfig(&presets[p], &configs[numOfConfigs++]);
+                    found = 1;
+                }
+            }
+            if (!found) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+    }
+
+    if (options.runs < 1) {
+        printf("Error: '--runs' expects a positive number.\n");
+        return 1;
+    }
+
+    // --generate only writes the workload, for use outside the harness
+    if (generateBase != NULL) {
+        long sourceLines;
+        if (!writeWorkload(&custom, generateBase, &sourceLines)) {
+            return 1;
+        }
+        printf("%s.asm: %ld lines\n", generateBase, sourceLines);
+        return 0;
+    }
+
+    if (hasCustom && numOfConfigs < MAX_BENCHMARKS) {
+        configs[numOfConfigs++] = custom;
+    }
+    if (numOfConfigs == 0) {
+        for (int p = 0; presets[p].name != NULL; p++) {
+            presetConfig(&presets[p], &configs[numOfConfigs++]);
+        }
+    }
+
+    mkdir(options.directory, 0777);  // Usually exists already
+    if (options.baselineFile != NULL) {
+        baselineCount = readBaseline(options.baselineFile, baseline, MAX_BENCHMARKS);
+        if (baselineCount == 0) {
+            printf("No baseline in %s, run 'make bench-baseline' to record one.\n", options.baselineFile);
+        }
+    }
+
+    printf("%-12s %9s %9s %8s %8s %12s %12s %9s\n", "config", "lines", "words", "wall s", "cpu s",
+           "lines/s", "words/s", "peak KB");
+    for (int i = 0; i < numOfConfigs; i++) {
+        if (!runBenchmark(&configs[i], &options, &results[i])) {
+            failed++;
+            continue;
+        }
+        printResult(&results[i], findBaseline(baseline, baselineCount, results[i].name));
+    }
+
+    if (options.saveFile != NULL && failed == 0) {
+        if (!saveResults(options.saveFile, results, numOfConfigs)) {
+            return 1;
+        }
+        printf("Baseline saved to %s\n", options.saveFile);
+    }
+    return failed > 0 ? 1 : 0;
+}
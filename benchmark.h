@@ -0,0 +1,40 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "workload.h"
+
+#define MAX_BENCHMARKS 32  // Configurations in one run
+
+// A named workload run by default: the default configuration with some settings changed
+typedef struct BenchmarkPreset {
+    const char *name;
+    long lines;
+    const char *settings;  // Space separated "key=value" settings
+} BenchmarkPreset;
+
+typedef struct BenchmarkOptions {
+    const char *assembler;     // The assembler executable to measure
+    const char *directory;     // Where the workloads are generated
+    int runs;                  // Runs of each workload, the fastest one counts
+    const char *baselineFile;  // Results to compare with, NULL for none
+    const char *saveFile;      // Where to save the results as the new baseline, NULL for none
+} BenchmarkOptions;
+
+// The measurements of one configuration, also the format of a baseline entry
+typedef struct BenchmarkResult {
+    char name[WORKLOAD_NAME_LENGTH];
+    long lines;              // Source lines of the workload
+    long words;              // Words in the object file
+    double seconds;          // Wall time of the fastest run
+    double cpuSeconds;       // CPU time of that run
+    double linesPerSecond;
+    double wordsPerSecond;
+    long peakKb;             // Largest peak RSS over the runs
+} BenchmarkResult;
+
+int presetConfig(const BenchmarkPreset *preset, WorkloadConfig *config);
+int readBaseline(const char *fileName, BenchmarkResult *baseline, int maxEntries);
+int runBenchmark(const WorkloadConfig *config, const BenchmarkOptions *options, BenchmarkResult *result);
+int main(int argc, char *argv[]);
+
+#endif // BENCHMARK_H
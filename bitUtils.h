@@ -1,12 +1,46 @@
 #ifndef BITUTILS_H
 #define BITUTILS_H
 
+// A machine word: 24 significant bits packed into a native unsigned integer
+typedef unsigned int Word;
+
+#define WORD_BITS 24
+#define WORD_MASK 0xFFFFFFu
+
+// A,R,E field (bits 2-0)
+#define ARE_ABSOLUTE    4u  // A = 1
+#define ARE_RELOCATABLE 2u  // R = 1
+#define ARE_EXTERNAL    1u  // E = 1
+
+// Bit positions of the first word fields
+#define OPCODE_SHIFT      18  // Bits 23-18: opcode (6 bits)
+#define SOURCE_MODE_SHIFT 16  // Bits 17-16: source addressing mode (2 bits)
+#define SOURCE_REG_SHIFT  13  // Bits 15-13: source register (3 bits)
+#define TARGET_MODE_SHIFT 11  // Bits 12-11: target addressing mode (2 bits)
+#define TARGET_REG_SHIFT   8  // Bits 10-8: target register (3 bits)
+#define FUNCT_SHIFT        3  // Bits 7-3: funct (5 bits)
+#define OPERAND_SHIFT      3  // Bits 23-3: operand value of an extra word (21 bits)
+
+#define OPERAND_MASK 0x1FFFFFu
+
+// Field-packing helpers, a negative field value (unused field) packs as zero
+#define PACK_FIELD(value, bits, shift) \
+    ((value) < 0 ? 0u : (((Word)(value) & ((1u << (bits)) - 1u)) << (shift)))
+#define PACK_OPCODE(value)      PACK_FIELD(value, 6, OPCODE_SHIFT)
+#define PACK_SOURCE_MODE(mode)  PACK_FIELD(mode, 2, SOURCE_MODE_SHIFT)
+#define PACK_SOURCE_REG(reg)    PACK_FIELD(reg, 3, SOURCE_REG_SHIFT)
+#define PACK_TARGET_MODE(mode)  PACK_FIELD(mode, 2, TARGET_MODE_SHIFT)
+#define PACK_TARGET_REG(reg)    PACK_FIELD(reg, 3, TARGET_REG_SHIFT)
+#define PACK_FUNCT(funct)       PACK_FIELD(funct, 5, FUNCT_SHIFT)
+
+// Packs a signed value into the 21-bit operand field of an extra word, with its A,R,E bits
+#define PACK_OPERAND(value, are) \
+    (((((Word)(value)) & OPERAND_MASK) << OPERAND_SHIFT) | (Word)(are))
+
+// Packs a signed value as a 24-bit two's complement data word
+#define PACK_DATA(value) (((Word)(value)) & WORD_MASK)
+
 // Function prototypes
-char *intTo2BitBinary(int num);
-char *intTo3BitBinary(int num);
-char *intTo5BitBinary(int num);
-char *intTo6BitBinary(int num);
-char *intTo24BitBinary(int num);
-char *binaryToHexString(const char *binary);
+Word packOperandFields(int sourceMode, int sourceReg, int targetMode, int targetReg);
 
 #endif
@@ -0,0 +1,199 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "cache.h"
+#include "globals.h"
+#include "sourceReader.h"
+#include <pthread.h>
+
+#define HASH_MULTIPLIER 0x9E3779B97F4A7C15ull
+
+// Mixes the bits of a 64-bit value (the MurmurHash3 finalizer)
+static uint64_t mix(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDull;
+    value ^= value >> 33;
+    value *= 0xC4CEB9FE1A85EC53ull;
+    value ^= value >> 33;
+    return value;
+}
+
+// Fast 64-bit hash of a byte string, eight bytes per step
+uint64_t hashBytes(const unsigned char *data, size_t length, uint64_t seed) {
+    uint64_t hash = seed ^ (length * HASH_MULTIPLIER);
+    size_t i = 0;
+
+    for (; i + 8 <= length; i += 8) {
+        uint64_t block;
+        memcpy(&block, data + i, 8);
+        hash = (hash ^ mix(block)) * HASH_MULTIPLIER;
+    }
+
+    uint64_t tail = 0;
+    for (size_t shift = 0; i < length; i++, shift += 8) {
+        tail |= (uint64_t)data[i] << shift;
+    }
+    return mix(hash ^ mix(tail));
+}
+
+/**
+ * @brief Computes the cache key of a source file: a hash of its bytes, the assembler
+ * version and the options that change the output.
+ *
+ * @return int 1 on success, 0 if the file can't be read.
+ */
+int computeCacheKey(const char *inputFile, unsigned options, char key[CACHE_KEY_LENGTH + 1]) {
+    SourceFile source;
+    const char *version = ASSEMBLER_VERSION;
+
+    if (!openSourceFile(inputFile, &source)) {
+        return 0;
+    }
+    uint64_t seed = hashBytes((const unsigned char *)version, strlen(version), options);
+    uint64_t hash = hashBytes((const unsigned char *)source.text, source.length, seed);
+    closeSourceFile(&source);
+
+    snprintf(key, CACHE_KEY_LENGTH + 1, "%016llx", (unsigned long long)hash);
+    return 1;
+}
+
+// Returns 1 if the file holds exactly these bytes
+static int hasContent(const char *fileName, const char *data, size_t length) {
+    SourceFile file;
+    int same;
+
+    if (!openSourceFile(fileName, &file)) {
+        return 0;
+    }
+    same = (file.length == length) && (length == 0 || memcmp(file.text, data, length) == 0);
+    closeSourceFile(&file);
+    return same;
+}
+
+// Fills 'temporary' with a name next to 'fileName' that no other process or thread uses
+static void temporaryName(char *temporary, size_t size, const char *fileName) {
+    snprintf(temporary, size, "%s.%ld.%lx.tmp", fileName, (long)getpid(), (unsigned long)pthread_self());
+}
+
+/**
+ * @brief Writes a file only if its content changes, so its modification time
+ * is left alone when the output is the same as before.
+ *
+ * The content is written under a temporary name and renamed over the file. An output
+ * restored from the cache is a hard link to the cache entry, writing it in place
+ * would change the entry too.
+ *
+ * @return int 1 if the file was written, 0 if it already held the content, -1 on error.
+ */
+int writeIfChanged(const char *fileName, const char *data, size_t length) {
+    char temporary[MAX * 2 + 32];
+
+    if (hasContent(fileName, data, length)) {
+        return 0;
+    }
+
+    temporaryName(temporary, sizeof(temporary), fileName);
+    FILE *file = fopen(temporary, "wb");
+    if (file == NULL) {
+        return -1;
+    }
+    size_t written = fwrite(data, 1, length, file);
+    if (fclose(file) != 0 || written != length || rename(temporary, fileName) != 0) {
+        unlink(temporary);
+        return -1;
+    }
+    return 1;
+}
+
+// Copies a file, for when it can't be hard linked (another file system)
+static int copyFile(const char *from, const char *to) {
+    SourceFile source;
+
+    if (!openSourceFile(from, &source)) {
+        return 0;
+    }
+    int copied = writeIfChanged(to, source.text, source.length) >= 0;
+    closeSourceFile(&source);
+    return copied;
+}
+
+/**
+ * @brief Restores the outputs of a cached assembly.
+ *
+ * An entry is complete once its .ob exists, since it is stored last. Each output
+ * that differs from the cached one is replaced by a hard link to it (a copy across
+ * file systems), outputs that already match are left untouched. The messages the
+ * original assembly printed, kept in the entry's .log, are printed again.
+ *
+ * @return int 1 if the entry was found and restored, 0 on a miss.
+ */
+int restoreFromCache(const char *cacheDir, const char *key, const char *baseFile) {
+    static const char *extensions[] = CACHE_EXTENSIONS;
+    char cached[MAX * 2];
+    char output[MAX];
+    char temporary[MAX + 32];
+    struct stat info;
+    SourceFile log;
+
+    snprintf(cached, sizeof(cached), "%s/%s.ob", cacheDir, key);
+    if (stat(cached, &info) != 0) {
+        return 0;
+    }
+
+    for (int i = 0; extensions[i] != NULL; i++) {
+        SourceFile file;
+
+        snprintf(cached, sizeof(cached), "%s/%s.%s", cacheDir, key, extensions[i]);
+        snprintf(output, sizeof(output), "%s.%s", baseFile, extensions[i]);
+        if (!openSourceFile(cached, &file)) {
+            continue;  // This output isn't produced for the source
+        }
+        int same = hasContent(output, file.text, file.length);
+        closeSourceFile(&file);
+        if (same) {
+            continue;
+        }
+
+        // Link under a temporary name, then rename over the output in one step
+        temporaryName(temporary, sizeof(temporary), output);
+        unlink(temporary);
+        if (link(cached, temporary) == 0) {
+            int renamed = rename(temporary, output) == 0;
+            unlink(temporary);  // Still there if another thread already linked the output to the entry
+            if (!renamed) {
+                return 0;
+            }
+        } else if (!copyFile(cached, output)) {
+            return 0;
+        }
+    }
+
+    snprintf(cached, sizeof(cached), "%s/%s.%s", cacheDir, key, CACHE_LOG_EXTENSION);
+    if (openSourceFile(cached, &log)) {
+        fwrite(log.text, 1, log.length, context->output);
+        closeSourceFile(&log);
+    }
+    return 1;
+}
+
+// Stores an output in the cache under its key. The file is written under a temporary
+// name and renamed, so concurrent runs never see a partial entry
+void storeInCache(const char *cacheDir, const char *key, const char *extension, const char *data, size_t length) {
+    char cached[MAX * 2];
+    char temporary[MAX * 2 + 32];
+
+    mkdir(cacheDir, 0777);  // Fails harmlessly if the directory exists
+    snprintf(cached, sizeof(cached), "%s/%s.%s", cacheDir, key, extension);
+    temporaryName(temporary, sizeof(temporary), cached);
+
+    FILE *file = fopen(temporary, "wb");
+    if (file == NULL) {
+        return;
+    }
+    size_t written = fwrite(data, 1, length, file);
+    if (fclose(file) != 0 || written != length || rename(temporary, cached) != 0) {
+        unlink(temporary);
+    }
+}
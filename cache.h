@@ -0,0 +1,19 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CACHE_KEY_LENGTH 16  // Hex digits of a 64-bit key
+
+// Output file extensions kept in the cache, in the order they are restored
+#define CACHE_EXTENSIONS {"ent", "ext", "obj", "ob", NULL}
+#define CACHE_LOG_EXTENSION "log"  // Messages printed by the assembly, stored before the .ob
+
+uint64_t hashBytes(const unsigned char *data, size_t length, uint64_t seed);
+int computeCacheKey(const char *inputFile, unsigned options, char key[CACHE_KEY_LENGTH + 1]);
+int restoreFromCache(const char *cacheDir, const char *key, const char *baseFile);
+void storeInCache(const char *cacheDir, const char *key, const char *extension, const char *data, size_t length);
+int writeIfChanged(const char *fileName, const char *data, size_t length);
+
+#endif
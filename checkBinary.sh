@@ -0,0 +1,46 @@
+#!/bin/sh
+# Checks that the binary object (.obj) of a generated workload holds the words, entries and
+# externals of its .ob, .ent and .ext files, run by 'make check-binary'.
+# Usage: checkBinary.sh [DIR]  (the directory holding assembler, disassembler and benchmark)
+tools=$(cd "${1:-.}" && pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+cd "$work" || exit 1
+failed=0
+
+fail() {
+    echo "FAIL: $1"
+    failed=1
+}
+
+"$tools/benchmark" --generate work lines=20000 externs=50 extern-refs=10 entries=200 > /dev/null
+if ! "$tools/assembler" -b work > /dev/null || [ ! -f work.obj ]; then
+    fail "the workload didn't assemble into work.obj"
+    exit 1
+fi
+
+# The source recovered from work.obj is the one recovered from work.ob, work.ent and work.ext.
+# --verify re-assembles it and compares the words, entries and externals of each with the result,
+# so the two hold the same
+"$tools/disassembler" work > text.txt
+"$tools/disassembler" -b work > binary.txt
+if ! cmp -s text.txt binary.txt; then
+    fail "the source recovered from work.obj differs from the one of work.ob"
+fi
+if ! "$tools/disassembler" --verify work > /dev/null; then
+    fail "--verify rejected work.ob, work.ent and work.ext"
+fi
+if ! "$tools/disassembler" --verify -b work > /dev/null; then
+    fail "--verify rejected work.obj"
+fi
+
+# A byte changed after the header fails the CRC check
+cp work.obj bad.obj
+printf 'U' | dd of=bad.obj bs=1 seek=40 conv=notrunc 2> /dev/null
+cmp -s work.obj bad.obj && printf '*' | dd of=bad.obj bs=1 seek=40 conv=notrunc 2> /dev/null
+if ! "$tools/disassembler" -b bad | grep -q "not a valid binary object"; then
+    fail "a corrupt .obj was read"
+fi
+
+[ $failed -eq 0 ] && echo "Binary object checks passed."
+exit $failed
@@ -0,0 +1,45 @@
+#!/bin/sh
+# Regression checks of the assembly cache (--cache), run by 'make check-cache'.
+# Usage: checkCache.sh [ASSEMBLER]
+assembler=$(cd "$(dirname "${1:-./assembler}")" && pwd)/$(basename "${1:-./assembler}")
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+cd "$work" || exit 1
+failed=0
+
+printf 'MAIN: mov r3, LIST\n add r2, r1\n jmp &END\nEND: stop\nLIST: .data 6, -9, 15\n' > A.asm
+printf 'MAIN: mov r1, r2\n stop\n' > B.asm
+printf 'L: .extern X\nMAIN: jmp X\n stop\n' > W.asm
+"$assembler" A > /dev/null && cp A.ob expected.ob
+
+# A restored output is a hard link to the cache entry: rewriting the output
+# without --cache must not change the entry
+cp A.asm X.asm; "$assembler" --cache cache X > /dev/null
+cp B.asm X.asm; "$assembler" --cache cache X > /dev/null
+cp A.asm X.asm; "$assembler" --cache cache X > /dev/null
+cp B.asm X.asm; "$assembler" X > /dev/null
+cp A.asm X.asm; "$assembler" --cache cache X > /dev/null
+if ! cmp -s X.ob expected.ob; then
+    echo "FAIL: rewriting a restored output changed its cache entry"
+    failed=1
+fi
+
+# A cache hit prints the warnings of the original assembly
+cp W.asm Y.asm
+"$assembler" --cache cache Y > first.txt
+"$assembler" --cache cache Y > hit.txt
+if [ ! -s first.txt ] || ! cmp -s first.txt hit.txt; then
+    echo "FAIL: a cache hit didn't print the warnings of the original assembly"
+    failed=1
+fi
+
+# Restoring the same base name on several threads leaves no temporary files
+echo stale > Y.ob
+"$assembler" -j 4 --cache cache Y Y Y Y > /dev/null
+if ls | grep -q '\.tmp$'; then
+    echo "FAIL: temporary files were left behind"
+    failed=1
+fi
+
+[ $failed -eq 0 ] && echo "Cache checks passed."
+exit $failed
@@ -0,0 +1,76 @@
+#!/bin/sh
+# Regression checks of the linker, the disassembler, the object readers and the --stats
+# report, run by 'make check-tools'.
+# Usage: checkTools.sh [DIR]  (the directory holding assembler, linker and disassembler)
+tools=$(cd "${1:-.}" && pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+cd "$work" || exit 1
+failed=0
+
+fail() {
+    echo "FAIL: $1"
+    failed=1
+}
+
+printf '.extern FN\nMAIN: jsr FN\n stop\n' > caller.asm
+printf '.entry FN\nFN: rts\n' > callee.asm
+"$tools/assembler" caller callee > /dev/null
+
+# Linker: an E word that no .ext line lists is an undefined reference
+cp caller.ob nolist.ob
+if "$tools/linker" -o unlisted nolist callee > unlisted.txt || [ -f unlisted.ob ]; then
+    fail "the linker accepted an external word missing from the .ext file"
+fi
+
+# Linker: '-o' without a name is reported as such, and relinking leaves an unchanged output alone
+if ! "$tools/linker" -o | grep -q "'-o' expects an output name"; then
+    fail "'linker -o' didn't ask for an output name"
+fi
+"$tools/linker" -o linked caller callee > /dev/null
+touch -t 200001010000 linked.ob
+"$tools/linker" -o linked caller callee > /dev/null
+if [ -n "$(find linked.ob -newer caller.asm)" ]; then
+    fail "relinking rewrote an unchanged linked.ob"
+fi
+
+# Object reader: a counts line that overflows or claims more words than the file can hold is rejected
+for counts in "99999999999999999999 1" "2000000000 2000000000" "5000 1"; do
+    { echo "$counts"; tail -n +2 caller.ob; } > badcounts.ob
+    if ! "$tools/disassembler" badcounts 2>&1 | grep -q "Bad counts line"; then
+        fail "the counts line '$counts' wasn't reported as a bad header"
+    fi
+done
+
+# Disassembler: generated labels never take the name of a symbol, whatever order the .ent lists them in.
+# M105 names address 100, so the label generated for address 105 must not be M105
+printf '.entry M105\n.entry L110\nM105: jmp THERE\nL110: prn #1\n stop\nTHERE: stop\n' > prefix.asm
+"$tools/assembler" prefix > /dev/null
+if ! "$tools/disassembler" --verify prefix > prefix.txt; then
+    fail "a generated label clashed with an entry name"
+fi
+
+# Disassembler: --verify compares the entries and externals too. caller.ext names the word after
+# the external operand, so the words still verify but the .ext file doesn't
+cp caller.ob badext.ob
+sed 's/ 0*101$/ 0000102/' caller.ext > badext.ext
+if ! "$tools/disassembler" --verify caller > /dev/null || ! "$tools/disassembler" --verify callee > /dev/null; then
+    fail "--verify rejected an object with matching .ent and .ext files"
+fi
+if "$tools/disassembler" --verify badext > badext.txt; then
+    fail "--verify accepted an .ext file that doesn't match the external references"
+fi
+
+# --stats=json: a file name with a quote and a backslash still gives valid JSON
+if command -v python3 > /dev/null; then
+    cp callee.asm 'we"ird\name.asm'
+    "$tools/assembler" --stats=json 'we"ird\name' | grep '^{' > stats.json
+    if [ ! -s stats.json ] || ! python3 -c 'import json, sys; [json.loads(line) for line in sys.stdin]' < stats.json 2> /dev/null; then
+        fail "--stats=json printed invalid JSON for a file name with a quote"
+    fi
+else
+    echo "Skipped the --stats=json check, python3 is needed to parse the JSON"
+fi
+
+[ $failed -eq 0 ] && echo "Tool checks passed."
+exit $failed
@@ -3,65 +3,110 @@
 #include <string.h>
 #include "globals.h"
 #include "dataStructures.h"
+#include "errors.h"
 
 
+// FNV-1a hash of a symbol or macro name
+unsigned long hashName(const char *name) {
+    unsigned long hash = 2166136261UL;
+    while (*name) {
+        hash ^= (unsigned char)*name++;
+        hash = (hash * 16777619UL) & 0xFFFFFFFFUL;
+    }
+    return hash;
+}
+
+// Returns the slot holding the id of 'name', or the empty slot where it would be inserted
+static NameId *findNameSlot(const char *name) {
+    NamePool *pool = &context->namePool;
+    unsigned long mask = (unsigned long)pool->slotCapacity - 1;
+    unsigned long i = hashName(name) & mask;
+
+    pool->lookups++;
+    while (1) {
+        pool->probes++;
+        if (pool->slots[i] == NO_NAME || strcmp(pool->names[pool->slots[i]], name) == 0) {
+            return &pool->slots[i];
+        }
+        i = (i + 1) & mask;  // Linear probing
+    }
+}
+
+// Doubles the hash slots of the name pool (or creates them), keeping the load factor at most 1/2
+static void growNameSlots() {
+    NamePool *pool = &context->namePool;
+    int newCapacity = (pool->slotCapacity > 0) ? pool->slotCapacity * 2 : 64;
+
+    trackedFree(pool->slots, pool->slotCapacity * sizeof(NameId), ALLOC_NAMES);
+    pool->slots = (NameId *)trackedAlloc(newCapacity * sizeof(NameId), ALLOC_NAMES);
+    pool->slotCapacity = newCapacity;
+    for (int i = 0; i < newCapacity; i++) {
+        pool->slots[i] = NO_NAME;
+    }
+
+    // Re-insert the existing names; rehashing is not counted in the lookup statistics
+    unsigned long mask = (unsigned long)newCapacity - 1;
+    for (NameId id = 0; id < pool->count; id++) {
+        unsigned long j = hashName(pool->names[id]) & mask;
+        while (pool->slots[j] != NO_NAME) {
+            j = (j + 1) & mask;
+        }
+        pool->slots[j] = id;
+    }
+}
+
 /**
- * @brief Inserts an opcode into the opcode linked list.
- * 
- * @param name Pointer to the opcode name.
- * @param value Numeric value assigned to the opcode.
- * @param numOfOperands Number of operands the opcode requires.
- * @param funct Additional function code for the opcode.
+ * @brief Returns the id of a name, adding the name to the pool if it is new.
+ *
+ * The text is copied into the file's arena, so the id stays valid until the file is done.
  */
-void insertOpcode(char *name, int value, int numOfOperands, int funct) {
-    Opcode *newOpcode;
+NameId internName(const char *name) {
+    NamePool *pool = &context->namePool;
 
-    /* Allocate memory for a new opcode */
-    newOpcode = (Opcode *)malloc(sizeof(Opcode));
-    if (newOpcode == NULL) {
-        printf("Memory allocation failed for opcode '%s'.\n", name);
-        return;
+    if (2 * (pool->count + 1) > pool->slotCapacity) {
+        growNameSlots();
+    }
+
+    NameId *slot = findNameSlot(name);
+    if (*slot != NO_NAME) {
+        return *slot;
     }
-    
-    /* Set the opcode fields */
-    strcpy(newOpcode->name, name);
-    newOpcode->value = value;
-    newOpcode->numOfOperands = numOfOperands;
-    newOpcode->funct = funct;
-    newOpcode->next = NULL;
 
-    /* Insert at the beginning of the linked list */
-    newOpcode->next = opcodeList;
-    opcodeList = newOpcode;
+    if (pool->count == pool->capacity) {
+        int newCapacity = (pool->capacity > 0) ? pool->capacity * 2 : 64;
+        pool->names = (const char **)trackedRealloc(pool->names, pool->capacity * sizeof(const char *),
+                                                    newCapacity * sizeof(const char *), ALLOC_NAMES);
+        pool->capacity = newCapacity;
+    }
+
+    pool->names[pool->count] = arenaStrdup(context->arena, name, ALLOC_NAMES);
+    *slot = pool->count;
+    return pool->count++;
 }
 
+// Returns the id of a name, or NO_NAME if it was never interned
+NameId findName(const char *name) {
+    if (context->namePool.count == 0) {
+        return NO_NAME;
+    }
+    return *findNameSlot(name);
+}
 
-/**
- * @brief Populates the opcode list with predefined opcodes.
- */
-void populateOpcodeList() {
-    /* Insert each opcode with its corresponding value, number of operands, and funct value */
-    insertOpcode("mov", 0, 2, -1);     /* No funct */
-    insertOpcode("cmp", 1, 2, -1);     /* No funct */
-    insertOpcode("add", 2, 2, 1);      /* funct = 1 */
-    insertOpcode("sub", 2, 2, 2);      /* funct = 2 */
-    insertOpcode("lea", 4, 2, -1);     /* No funct */
-    insertOpcode("clr", 5, 1, 1);      /* funct = 1 */
-    insertOpcode("not", 5, 1, 2);      /* funct = 2 */
-    insertOpcode("inc", 5, 1, 3);      /* funct = 3 */
-    insertOpcode("dec", 5, 1, 4);      /* funct = 4 */
-    insertOpcode("jmp", 9, 1, 1);      /* funct = 1 */
-    insertOpcode("bne", 9, 1, 2);      /* funct = 2 */
-    insertOpcode("jsr", 9, 1, 3);      /* funct = 3 */
-    insertOpcode("red", 12, 1, -1);    /* No funct */
-    insertOpcode("prn", 13, 1, -1);    /* No funct */
-    insertOpcode("rts", 14, 0, -1);    /* No funct */
-    insertOpcode("stop", 15, 0, -1);   /* No funct (stop) */
+// Returns the text of an interned name
+const char *nameText(NameId id) {
+    return context->namePool.names[id];
 }
 
+// Frees the name pool's tables, the text of the names is in the file's arena
+void freeNamePool() {
+    NamePool *pool = &context->namePool;
+    trackedFree(pool->names, pool->capacity * sizeof(const char *), ALLOC_NAMES);
+    trackedFree(pool->slots, pool->slotCapacity * sizeof(NameId), ALLOC_NAMES);
+    memset(&context->namePool, 0, sizeof(NamePool));
+}
 
 // Function to insert a symbol into the symbol table
-void insertSymbol(Symbol **head, char *name, int value, char properties[3][MAX]) {
+void insertSymbol(Symbol **head, char *name, int value, unsigned attributes) {
     // Remove the colon at the end of the symbol name, if present
     int len = strlen(name);
     if (name[len - 1] == ':') {
@@ -69,250 +114,399 @@ void insertSymbol(Symbol **head, char *name, int value, char properties[3][MAX])
     }
 
     // Check if the symbol already exists in the table
-    Symbol *current = *head;
-    while (current != NULL) {
-        if (strcmp(current->name, name) == 0) {
-            printf("Error: Symbol '%s' already exists in the table.\n", name);
-            return;
-        }
-        current = current->next;
+    NameId id = internName(name);
+    if (findSymbolById(id) != NULL) {
+        fprintf(context->output, "Error: Symbol '%s' already exists in the table.\n", name);
+        return;
     }
 
-    // Create a new symbol
-    Symbol *newSymbol = (Symbol *)malloc(sizeof(Symbol));
-    if (newSymbol == NULL) {
-        printf("Memory allocation error!\n");
-        return;
+    // The index has an entry for every name in the pool
+    if (context->symbolIndex.capacity < context->namePool.capacity) {
+        int newCapacity = context->namePool.capacity;
+        Symbol **newByName = (Symbol **)trackedRealloc(context->symbolIndex.byName,
+                                                       context->symbolIndex.capacity * sizeof(Symbol *),
+                                                       newCapacity * sizeof(Symbol *), ALLOC_NAMES);
+        memset(newByName + context->symbolIndex.capacity, 0, (newCapacity - context->symbolIndex.capacity) * sizeof(Symbol *));
+        context->symbolIndex.byName = newByName;
+        context->symbolIndex.capacity = newCapacity;
     }
 
-    // Set the symbol's name, value, and properties
-    strcpy(newSymbol->name, name);
+    // Create a new symbol
+    Symbol *newSymbol = (Symbol *)arenaAlloc(context->arena, sizeof(Symbol), ALLOC_NAMES);
+
+    // Set the symbol's name, value, and attributes
+    newSymbol->name = id;
     newSymbol->value = value;
-    for (int i = 0; i < 3; i++) {
-        strcpy(newSymbol->properties[i], properties[i]);
-    }
+    newSymbol->attributes = attributes;
     newSymbol->next = NULL;
 
-    // Append the new symbol at the end of the list (instead of inserting at the head)
+    // Append the new symbol at the end of the list, keeping insertion order
     if (*head == NULL) {
-        // If the list is empty, set the new symbol as the head
         *head = newSymbol;
     } else {
-        // Traverse to the end of the list and append the new symbol
-        Symbol *last = *head;
-        while (last->next != NULL) {
-            last = last->next;
-        }
-        last->next = newSymbol;
+        context->symbolIndex.tail->next = newSymbol;
     }
+    context->symbolIndex.tail = newSymbol;
 
-    printf("Symbol '%s' added to the table.\n", name);
+    // Index the new symbol by name
+    context->symbolIndex.byName[id] = newSymbol;
+    context->symbolIndex.count++;
+
+    logMessage(LOG_DEBUG, LOG_TABLES, "Symbol '%s' added to the table.\n", name);
 }
 
 
 // Adds a symbol to symbols table using insertSymbol func
-void addSymbolToTable(char *name, int value, char *prop1, char *prop2, char *prop3) {
-    char properties[3][MAX];  // Array to store the final properties
+void addSymbolToTable(char *name, int value, unsigned attributes) {
+    insertSymbol(&context->symbolTable, name, value, attributes);
+}
 
-    // Step 1: Assign the provided properties or empty strings if NULL
-    strcpy(properties[0], (prop1 != NULL) ? prop1 : "");
-    strcpy(properties[1], (prop2 != NULL) ? prop2 : "");
-    strcpy(properties[2], (prop3 != NULL) ? prop3 : "");
+// Marks a symbol as 'entry' and appends it to the entry list, once per symbol
+void markEntrySymbol(Symbol *symbol) {
+    if (symbol->attributes & SYMBOL_ENTRY) {
+        return;  // Already listed by an earlier .entry line
+    }
+    symbol->attributes |= SYMBOL_ENTRY;
+
+    EntryList *list = &context->entryList;
+    if (list->count == list->capacity) {
+        int newCapacity = (list->capacity > 0) ? list->capacity * 2 : 16;
+        list->symbols = (Symbol **)trackedRealloc(list->symbols, list->capacity * sizeof(Symbol *),
+                                                  newCapacity * sizeof(Symbol *), ALLOC_NAMES);
+        list->capacity = newCapacity;
+    }
+    list->symbols[list->count++] = symbol;
+}
 
-    // Step 2: Insert the symbol into the table with the final properties
-    insertSymbol(&symbolTable, name, value, properties);
+// Frees the entry list, the symbols themselves are in the file's arena
+void freeEntryList() {
+    trackedFree(context->entryList.symbols, context->entryList.capacity * sizeof(Symbol *), ALLOC_NAMES);
+    memset(&context->entryList, 0, sizeof(EntryList));
 }
 
 /**
- * @brief Finds an opcode in the linked list by name.
+ * @brief Finds an opcode in the static opcode table by name.
  * 
  * @param opcodeName Pointer to the name of the opcode to search for.
- * @return Opcode* Pointer to the matching opcode, or NULL if not found.
+ * @return const Opcode* Pointer to the matching descriptor, or NULL if not found.
  */
-Opcode *findOpcode(char *opcodeName) {
-    Opcode *current;
+const Opcode *findOpcode(const char *opcodeName) {
+    int i;
 
-    /* Start at the head of the linked list */
-    current = opcodeList;
-    
-    /* Traverse the linked list */
-    while (current != NULL) {
-        /* Compare the given opcodeName with the current node's opcode name */
-        if (strcmp(current->name, opcodeName) == 0) {
-            printf("Returning: %s\n", current->name);
-            return current;  /* Return the pointer to the matching opcode */
+    /* Compare the first character before doing a full string comparison */
+    for (i = 0; i < NUM_OF_OPCODES; i++) {
+        if (opcodeTable[i].name[0] == opcodeName[0] && strcmp(opcodeTable[i].name, opcodeName) == 0) {
+            return &opcodeTable[i];  /* Return the pointer to the matching descriptor */
         }
-        current = current->next;  /* Move to the next node in the list */
     }
 
     return NULL;  /* Return NULL if no matching opcode is found */
 }
 
 
-// Function to insert an instruction into the list
-void addInstruction(char *binaryInstruction, int L) {
-    // Allocate memory for the new instruction node
-    InstructionNode *newNode = (InstructionNode *)malloc(sizeof(InstructionNode));
-    
-    if (newNode == NULL) {
-        printf("Memory allocation error\n");
+// Makes sure the code image has room for at least 'required' words
+static void growCodeImage(int required) {
+    int newCapacity = (context->codeImage.capacity > 0) ? context->codeImage.capacity : 64;
+    unsigned char *newUnresolved;
+
+    while (newCapacity < required) {
+        newCapacity *= 2;  // Grow geometrically so appends are amortized O(1)
+    }
+
+    context->codeImage.words = (Word *)trackedRealloc(context->codeImage.words, context->codeImage.capacity * sizeof(Word),
+                                                      newCapacity * sizeof(Word), ALLOC_CODE);
+
+    newUnresolved = (unsigned char *)trackedRealloc(context->codeImage.unresolved, (context->codeImage.capacity + 7) / 8,
+                                                    (newCapacity + 7) / 8, ALLOC_CODE);
+    // Clear the bitmap bytes that were just added
+    memset(newUnresolved + (context->codeImage.capacity + 7) / 8, 0, (newCapacity + 7) / 8 - (context->codeImage.capacity + 7) / 8);
+    context->codeImage.unresolved = newUnresolved;
+    context->codeImage.capacity = newCapacity;
+}
+
+// Function to insert an instruction (the first word at address IC) into the code image
+void addInstruction(Word instruction, int L) {
+    int index = context->IC - CODE_START_ADDRESS;
+
+    if (index < 0) {
+        fprintf(context->output, "Error: Instruction address %d is below the start of the code image\n", context->IC);
         return;
     }
 
-    // Copy the binary instruction to the new node
-    strcpy(newNode->instruction, binaryInstruction);
-    newNode->L = L;
-    newNode->Address = IC;
-    newNode->next = NULL;
+    if (index + L > context->codeImage.capacity) {
+        growCodeImage(index + L);
+    }
 
-    // If the list is empty, set this node as the first one
-    if (instructionList == NULL) {
-        instructionList = newNode;
-    } else {
-        // Traverse to the end of the list to append the new instruction
-        InstructionNode *current = instructionList;
-        while (current->next != NULL) {
-            current = current->next;
-        }
-        current->next = newNode;
+    // Any gap before this instruction is left as zero words
+    while (context->codeImage.count < index) {
+        context->codeImage.words[context->codeImage.count++] = 0;
     }
 
-    // Update the current pointer to the newly added instruction
-    InstructionNode *current = newNode;
+    context->codeImage.words[index] = instruction;
+    context->codeImage.unresolved[index / 8] &= (unsigned char)~(1u << (index % 8));
 
-    // If L > 1, add '?' placeholders for the extra words
+    // If L > 1, reserve placeholders for the extra words
     for (int i = 1; i < L; i++) {
-        InstructionNode *placeholderNode = (InstructionNode *)malloc(sizeof(InstructionNode));
-        if (placeholderNode == NULL) {
-            printf("Memory allocation error for placeholder\n");
-            return;
-        }
-        strcpy(placeholderNode->instruction, "???????????????????????");
-        placeholderNode->Address = IC + i;
-        placeholderNode->next = NULL;
+        context->codeImage.words[index + i] = PLACEHOLDER_WORD;
+        context->codeImage.unresolved[(index + i) / 8] |= (unsigned char)(1u << ((index + i) % 8));
+    }
 
-        current->next = placeholderNode;  // Link the placeholder node
-        current = placeholderNode;  // Move to the new placeholder node
+    if (context->codeImage.count < index + L) {
+        context->codeImage.count = index + L;
     }
 }
 
 // Function to update a specific placeholder with the correct instruction
-void updateInstruction(int position, char *newInstruction) {
-    InstructionNode *current = instructionList;
+void updateInstruction(int position, Word newInstruction) {
+    int index = position - CODE_START_ADDRESS;
 
-    // Traverse the list to find the node at 'position'
-    while (current != NULL && current->Address != position) {
-        current = current->next;
-    }
-
-    // Once the correct position is found, check if the placeholder is "??????..."
-    if (current != NULL && strcmp(current->instruction, "???????????????????????") == 0) {
+    // The word is addressed directly, check that it is still a placeholder
+    if (index >= 0 && index < context->codeImage.count && (context->codeImage.unresolved[index / 8] & (1u << (index % 8)))) {
         // Update the instruction
-        strcpy(current->instruction, newInstruction);
+        context->codeImage.words[index] = newInstruction;
+        context->codeImage.unresolved[index / 8] &= (unsigned char)~(1u << (index % 8));
     } else {
-        printf("Error: No placeholder at the specified position\n");
+        fprintf(context->output, "Error: No placeholder at the specified position\n");
     }
 }
 
 //Only for debugging
 void printInstructionList() {
-    InstructionNode *current = instructionList;
-    while (current != NULL) {
-        printf("IC: %d  Instruction: %s\n", current->Address, current->instruction);
-        current = current->next;
-    }
-}
-
-// Insert ASCII characters into dataArray from a string
-void insertData(int value, int *DC, char *binaryOfInt) {
-    DataNode *newNode = (DataNode *)malloc(sizeof(DataNode));
-    if (newNode == NULL) {
-        printf("Memory allocation error\n");
+    if (!logEnabled(LOG_DEBUG, LOG_TABLES)) {
         return;
     }
+    for (int i = 0; i < context->codeImage.count; i++) {
+        if (context->codeImage.unresolved[i / 8] & (1u << (i % 8))) {
+            fprintf(context->logOutput, "IC: %d  Instruction: ??????\n", i + CODE_START_ADDRESS);
+        } else {
+            fprintf(context->logOutput, "IC: %d  Instruction: %06x\n", i + CODE_START_ADDRESS, context->codeImage.words[i]);
+        }
+    }
+}
 
-    strcpy(newNode->binaryRep, binaryOfInt);
-    newNode->value = value;
-    newNode->next = NULL;
+// Frees the code image and leaves it empty for the next file
+void freeCodeImage() {
+    trackedFree(context->codeImage.words, context->codeImage.capacity * sizeof(Word), ALLOC_CODE);
+    trackedFree(context->codeImage.unresolved, (context->codeImage.capacity + 7) / 8, ALLOC_CODE);
+    context->codeImage.words = NULL;
+    context->codeImage.unresolved = NULL;
+    context->codeImage.count = 0;
+    context->codeImage.capacity = 0;
+}
 
-    if (dataList == NULL) {
-        dataList = newNode;
-    } else {
-        DataNode *current = dataList;
-        while (current->next != NULL) {
-            current = current->next;
+// Insert a value (a number or an ASCII character) into the data image at address DC
+void insertData(int value, int *DC) {
+    if (*DC >= context->dataImage.capacity) {
+        int newCapacity = (context->dataImage.capacity > 0) ? context->dataImage.capacity * 2 : 64;
+        while (newCapacity <= *DC) {
+            newCapacity *= 2;  // Grow geometrically so appends are amortized O(1)
         }
-        current->next = newNode;
+
+        context->dataImage.words = (Word *)trackedRealloc(context->dataImage.words,
+                                                          context->dataImage.capacity * sizeof(Word),
+                                                          newCapacity * sizeof(Word), ALLOC_DATA);
+        context->dataImage.capacity = newCapacity;
     }
 
+    context->dataImage.words[*DC] = PACK_DATA(value);
+    context->dataImage.count = *DC + 1;
+
     (*DC)++;  // Increment DC for each value added
 }
 
 //Only for debugging 
 void printDataList() {
-    DataNode *current = dataList;
-    int index = 0;
-    while (current != NULL) {
-        printf("Data[%d]: %d, binary: %s\n", index++, current->value, current->binaryRep);
-        current = current->next;
+    if (!logEnabled(LOG_DEBUG, LOG_TABLES)) {
+        return;
+    }
+    for (int i = 0; i < context->dataImage.count; i++) {
+        fprintf(context->logOutput, "Data[%d]: %06x\n", i, context->dataImage.words[i]);
     }
 }
 
+// Frees the data image and leaves it empty for the next file
+void freeDataImage() {
+    trackedFree(context->dataImage.words, context->dataImage.capacity * sizeof(Word), ALLOC_DATA);
+    context->dataImage.words = NULL;
+    context->dataImage.count = 0;
+    context->dataImage.capacity = 0;
+}
+
 /**
  * @brief Finds a symbol in the symbol table by name.
  * 
  * @param symbolName Pointer to the name of the symbol to search for.
  * @return Symbol* Pointer to the matching symbol, or NULL if not found.
  */
-Symbol *findSymbol(char *symbolName) {
-    Symbol *current;
+Symbol *findSymbol(const char *symbolName) {
+    /* A name that was never interned can't be a symbol */
+    return findSymbolById(findName(symbolName));
+}
+
+/**
+ * @brief Finds a symbol in the symbol table by name id.
+ *
+ * @param name Id of the name in the name pool, or NO_NAME.
+ * @return Symbol* Pointer to the matching symbol, or NULL if not found.
+ */
+Symbol *findSymbolById(NameId name) {
+    if (name == NO_NAME || name >= context->symbolIndex.capacity) {
+        return NULL;
+    }
+    return context->symbolIndex.byName[name];
+}
 
-    /* Start at the head of the symbol table */
-    current = symbolTable;
+/**
+ * @brief Frees the hash index, leaving an empty table. The symbols themselves are
+ * in the file's arena and go with it.
+ */
+void freeSymbolTable() {
+    context->symbolTable = NULL;
+
+    trackedFree(context->symbolIndex.byName, context->symbolIndex.capacity * sizeof(Symbol *), ALLOC_NAMES);
+    context->symbolIndex.byName = NULL;
+    context->symbolIndex.capacity = 0;
+    context->symbolIndex.count = 0;
+    context->symbolIndex.tail = NULL;
+}
 
-    /* Traverse the linked list */
-    while (current != NULL) {
-        /* Compare the given symbolName with the current node's symbol name */
-        if (strcmp(current->name, symbolName) == 0) {
-            return current;  /* Symbol found */
+/**
+ * @brief Prints the symbol table size and hash probe statistics.
+ */
+void printSymbolTableStats() {
+    if (!logEnabled(LOG_DEBUG, LOG_TABLES)) {
+        return;
+    }
+    NamePool *pool = &context->namePool;
+    fprintf(context->logOutput, "Symbol table: %d symbols, %d names in %d slots, %ld lookups, %ld probes (%.2f per lookup)\n",
+           context->symbolIndex.count, pool->count, pool->slotCapacity, pool->lookups, pool->probes,
+           pool->lookups > 0 ? (double)pool->probes / pool->lookups : 0.0);
+}
+
+// Starts an empty context for a new file, with the options of this run
+void initAssemblerContext(AssemblerContext *fileContext, FILE *output, Arena *arena, int singlePassMode, int keepExpandedFile) {
+    memset(fileContext, 0, sizeof(AssemblerContext));
+    fileContext->arena = arena;
+    fileContext->singlePassMode = singlePassMode;
+    fileContext->keepExpandedFile = keepExpandedFile;
+    fileContext->output = output;
+    fileContext->logOutput = output;
+    fileContext->logLevel = LOG_ERROR;  // Quiet unless the caller asks for more
+    fileContext->logCategories = LOG_ALL;
+}
+
+// Appends length bytes of text to a source buffer as null-terminated lines, every '\n'
+// in the text starts a new line. Returns the first appended line, which stays valid
+// until the next append
+char *appendSourceLine(SourceBuffer *buffer, const char *text, size_t length) {
+    char *line;
+
+    if (buffer->length + length + 1 > buffer->capacity) {
+        size_t newCapacity = (buffer->capacity > 0) ? buffer->capacity * 2 : 4096;
+        while (newCapacity < buffer->length + length + 1) {
+            newCapacity *= 2;  // Grow geometrically so appends are amortized O(1)
         }
-        current = current->next;  /* Move to the next node in the list */
+
+        buffer->text = (char *)trackedRealloc(buffer->text, buffer->capacity, newCapacity, ALLOC_SOURCE);
+        buffer->capacity = newCapacity;
     }
 
-    return NULL;  /* Symbol not found */
+    line = buffer->text + buffer->length;
+    for (size_t i = 0; i < length; i++) {
+        line[i] = (text[i] == '\n') ? '\0' : text[i];
+    }
+    line[length] = '\0';
+    buffer->length += length + 1;
+    return line;
 }
 
-// Function to add an external reference to the list
-void addExternalReference(char *symbolName, int address) {
-    // Allocate memory for a new external reference
-    ExternalReference *newReference = (ExternalReference *)malloc(sizeof(ExternalReference));
-    if (newReference == NULL) {
-        printf("Memory allocation failed for external reference\n");
-        exit(1);
+// Returns the line starting at *offset and moves *offset to the next line.
+// Returns NULL when there are no more lines
+char *nextSourceLine(SourceBuffer *buffer, size_t *offset) {
+    char *line;
+
+    if (*offset >= buffer->length) {
+        return NULL;
+    }
+
+    line = buffer->text + *offset;
+    *offset += strlen(line) + 1;  // Skip the '\0'
+    return line;
+}
+
+// Frees a source buffer and leaves it empty
+void freeSourceBuffer(SourceBuffer *buffer) {
+    trackedFree(buffer->text, buffer->capacity, ALLOC_SOURCE);
+    buffer->text = NULL;
+    buffer->length = 0;
+    buffer->capacity = 0;
+}
+
+// Records a label operand to be patched after the first pass (single-pass mode)
+void addFixup(NameId label, int address, int mode) {
+    if (context->fixupList.count == context->fixupList.capacity) {
+        int newCapacity = (context->fixupList.capacity > 0) ? context->fixupList.capacity * 2 : 64;
+        context->fixupList.fixups = (Fixup *)trackedRealloc(context->fixupList.fixups,
+                                                            context->fixupList.capacity * sizeof(Fixup),
+                                                            newCapacity * sizeof(Fixup), ALLOC_FIXUPS);
+        context->fixupList.capacity = newCapacity;
+    }
+
+    Fixup *fixup = &context->fixupList.fixups[context->fixupList.count++];
+    fixup->label = label;
+    fixup->address = address;
+    fixup->mode = mode;
+}
+
+// Keeps a copy of an .entry line, to be applied after the first pass (single-pass mode)
+void addEntryLine(const char *line) {
+    if (context->fixupList.entryCount == context->fixupList.entryCapacity) {
+        int newCapacity = (context->fixupList.entryCapacity > 0) ? context->fixupList.entryCapacity * 2 : 8;
+        context->fixupList.entryLines = (char **)trackedRealloc(context->fixupList.entryLines,
+                                                                context->fixupList.entryCapacity * sizeof(char *),
+                                                                newCapacity * sizeof(char *), ALLOC_FIXUPS);
+        context->fixupList.entryCapacity = newCapacity;
     }
 
+    context->fixupList.entryLines[context->fixupList.entryCount++] = arenaStrdup(context->arena, line, ALLOC_FIXUPS);
+}
+
+// Frees the fixups and the deferred .entry lines (the lines themselves are in the arena)
+void freeFixupList() {
+    trackedFree(context->fixupList.entryLines, context->fixupList.entryCapacity * sizeof(char *), ALLOC_FIXUPS);
+    trackedFree(context->fixupList.fixups, context->fixupList.capacity * sizeof(Fixup), ALLOC_FIXUPS);
+    context->fixupList.fixups = NULL;
+    context->fixupList.count = 0;
+    context->fixupList.capacity = 0;
+    context->fixupList.entryLines = NULL;
+    context->fixupList.entryCount = 0;
+    context->fixupList.entryCapacity = 0;
+}
+
+// Function to add an external reference to the list
+void addExternalReference(NameId symbol, int address) {
+    // Allocate the new external reference in the file's arena
+    ExternalReference *newReference = (ExternalReference *)arenaAlloc(context->arena, sizeof(ExternalReference), ALLOC_EXTERNALS);
+
     // Set the symbol name and address
-    strcpy(newReference->symbolName, symbolName);
+    newReference->symbol = symbol;
     newReference->address = address;
     newReference->next = NULL;
 
     // Insert the new reference at the end of the list
-    if (externalReferencesList == NULL) {
-        externalReferencesList = newReference;  // First element in the list
+    if (context->externalReferencesList == NULL) {
+        context->externalReferencesList = newReference;  // First element in the list
     } else {
-        ExternalReference *current = externalReferencesList;
-        while (current->next != NULL) {
-            current = current->next;
-        }
-        current->next = newReference;  // Insert at the end of the list
+        context->externalReferencesTail->next = newReference;  // Insert at the end of the list
     }
+    context->externalReferencesTail = newReference;
 }
 
 // Function to print the external references (or save to a file)
 void printExternalReferences() {
-    ExternalReference *current = externalReferencesList;
+    ExternalReference *current = context->externalReferencesList;
     while (current != NULL) {
-        printf("External symbol '%s' used at address %d\n", current->symbolName, current->address);
+        logMessage(LOG_DEBUG, LOG_TABLES, "External symbol '%s' used at address %d\n", nameText(current->symbol), current->address);
         current = current->next;
     }
 }
@@ -322,15 +516,11 @@ void updateDataSymbols(Symbol *head) {
     Symbol *current = head;
 
     while (current != NULL) {
-        // Check if the symbol has the "data" property
-        for (int i = 0; i < 3; i++) {
-            if (strcmp(current->properties[i], "data") == 0) {
-                // Update the value by adding
-                current->value += (ICF);
-                printf("Updated symbol '%s' with new value %d.\n", current->name, current->value);
-                break;  // No need to check the other properties
-            }
+        // Only data symbols move, by the final instruction counter
+        if (current->attributes & SYMBOL_DATA) {
+            current->value += (context->ICF);
+            logMessage(LOG_DEBUG, LOG_TABLES, "Updated symbol '%s' with new value %d.\n", nameText(current->name), current->value);
         }
         current = current->next;  // Move to the next symbol in the table
     }
-}
\ No newline at end of file
+}
\ No newline at end of file
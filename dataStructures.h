@@ -4,32 +4,81 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "bitUtils.h"
+#include "arena.h"
+#include "stats.h"
 
 #define MAX 80
 #define MAX_SYMBOL_LENGTH 31
 
+// Id of an interned name: its index in the name pool, see nameText
+typedef int NameId;
+#define NO_NAME -1
+
+// Every symbol name of a file, stored once. Symbols, external references and fixups
+// keep the small id instead of a copy, so names are compared as integers
+typedef struct NamePool {
+    const char **names;  // Text of each name by id, the strings are in the file's arena
+    int count;           // Number of names
+    int capacity;        // Number of entries allocated in names
+    NameId *slots;       // Hash slots (linear probing), NO_NAME marks an empty slot
+    int slotCapacity;    // Number of slots, always a power of two
+    long lookups;        // Number of lookups done, for distribution statistics
+    long probes;         // Number of slots examined by those lookups
+} NamePool;
+
+// Symbol attributes, combined in Symbol.attributes
+#define SYMBOL_CODE 1u       // Label of an instruction line
+#define SYMBOL_DATA 2u       // Label of a .data or .string line, relocated by ICF after the first pass
+#define SYMBOL_EXTERNAL 4u   // Declared by .extern
+#define SYMBOL_ENTRY 8u      // Exported by .entry
+
 // Structure for symbol table nodes
 typedef struct Symbol {
-    char name[MAX];
+    NameId name;
     int value;
-    char properties[3][MAX];
+    unsigned attributes;  // SYMBOL_* flags
     struct Symbol *next;
 } Symbol;
 
-// Structure for the instruction image linked list
-typedef struct InstructionNode {
-    char instruction[25];  // Each instruction word in 24-bit binary (plus null-terminator)
-    int L;
-    int Address;
-    struct InstructionNode *next;
-} InstructionNode;
-
-// Structure for the instruction image linked list
-typedef struct DataNode {
-    int value;  // The binary value or ASCII value to be stored
-    char binaryRep[25];
-    struct DataNode *next;  // Pointer to the next node
-} DataNode;
+// The entry symbols, in the order of their .entry lines, so the .ent file is
+// written without scanning the symbol table
+typedef struct EntryList {
+    Symbol **symbols;
+    int count;
+    int capacity;
+} EntryList;
+
+#define CODE_START_ADDRESS 100  // Address of the first instruction word
+
+// Index of the symbol table by name id, the symbols themselves stay linked in
+// insertion order so output generation remains deterministic
+typedef struct SymbolIndex {
+    Symbol **byName; // The symbol of each name id, NULL for names that are not symbols
+    int capacity;    // Number of entries allocated in byName
+    int count;       // Number of symbols in the index
+    Symbol *tail;    // Last symbol in insertion order, for O(1) appends
+} SymbolIndex;
+
+// Value of an extra word until the second pass (or a fixup) resolves it. A word whose symbol
+// is never found keeps it and is written as 000000. The original string encoding wrote "77ffff"
+// there: its '?' placeholder text read as binary and cut to six hex digits
+#define PLACEHOLDER_WORD 0
+
+// Structure for the instruction image: a growable array indexed by Address - CODE_START_ADDRESS
+typedef struct CodeImage {
+    Word *words;               // The instruction words, in address order
+    unsigned char *unresolved; // Bitmap, bit i is set while words[i] is a placeholder
+    int count;                 // Number of words in the image
+    int capacity;              // Number of words allocated
+} CodeImage;
+
+// Structure for the data image: a growable array indexed by DC
+typedef struct DataImage {
+    Word *words;   // The data words (numbers or ASCII values) in 24-bit two's complement
+    int count;     // Number of words in the image
+    int capacity;  // Number of words allocated
+} DataImage;
 
 typedef struct Macro {
     char name[MAX];
@@ -37,51 +86,202 @@ typedef struct Macro {
     struct Macro *next;
 } Macro;
 
+// Open-addressing hash index over the macro table, the macros stay linked in
+// definition order for diagnostics
+typedef struct MacroIndex {
+    Macro **slots;   // Hash slots (linear probing), NULL marks an empty slot
+    int capacity;    // Number of slots, always a power of two
+    int count;       // Number of macros in the index
+    Macro *tail;     // Last macro defined, for O(1) appends
+    long expansions; // Number of macro invocations expanded
+} MacroIndex;
+
+// Static descriptor of an opcode, see opcodeTable in globals.c
 typedef struct Opcode {
-    char name[MAX];         // Opcode name
-    int value;              // Opcode value
-    int numOfOperands;      // Number of operands
-    int funct;              // The funct field (additional property)
-    struct Opcode *next;    // Pointer to the next opcode in the list
+    const char *name;           // Opcode name
+    int value;                  // Opcode value
+    int numOfOperands;          // Number of operands
+    int funct;                  // The funct field (additional property), -1 if none
+    unsigned int sourceModes;   // Bitmask of valid source addressing modes (bit n = mode n)
+    unsigned int targetModes;   // Bitmask of valid target addressing modes (bit n = mode n)
+    Word firstWordTemplate;     // First word with opcode, funct and A,R,E already encoded
 } Opcode;
 
-// Define a structure to store valid addressing modes for an opcode
-typedef struct {
-    char name[MAX];       // Opcode name
-    int validSourceModes[4];  // Valid addressing modes for the source operand
-    int validTargetModes[4];  // Valid addressing modes for the target operand
-} OpcodeAddressingModes;
-
 typedef struct ExternalReference {
-    char symbolName[MAX];  // Name of the external symbol
+    NameId symbol;         // Name of the external symbol
     int address;           // The address in the code where the symbol is used
     struct ExternalReference *next;  // Pointer to the next reference in the list
 } ExternalReference;
 
+// An input file held in memory, mapped or read in one piece
+typedef struct SourceFile {
+    char *text;       // The file content, not null-terminated
+    size_t length;    // Number of bytes in the file
+    int isMapped;     // 1 if text is mapped, 0 if it was read into a malloc'd buffer
+    size_t capacity;  // Bytes allocated for a buffer that was read, 0 when mapped
+} SourceFile;
+
+// A line of a source file: a pointer into the file content and a length, without the '\n'
+typedef struct LineView {
+    const char *start;
+    size_t length;
+} LineView;
+
+// The expanded source produced by the pre-assembler, handed to the first and second
+// pass in memory instead of through the .am file. The passes read the lines in place,
+// without modifying them
+typedef struct SourceBuffer {
+    char *text;       // The lines, each terminated by '\0'
+    size_t length;    // Number of bytes used
+    size_t capacity;  // Number of bytes allocated
+} SourceBuffer;
+
+// Line types, as classified by parseLine
+#define LINE_ERROR -1        // Invalid or unrecognized line
+#define LINE_COMMENT 0       // Comment (or empty) line
+#define LINE_DATA 1          // .data or .string directive
+#define LINE_EXTERN_ENTRY 2  // .extern or .entry directive
+#define LINE_OPCODE 3        // Instruction line
+
+// Directives
+#define DIRECTIVE_NONE 0
+#define DIRECTIVE_DATA 1
+#define DIRECTIVE_STRING 2
+#define DIRECTIVE_EXTERN 3
+#define DIRECTIVE_ENTRY 4
+
+// A source line tokenized once by parseLine, consumed by the first and second pass
+typedef struct LineRecord {
+    int type;                    // One of the LINE_* types
+    int hasLabel;                // 1 if the line starts with a "label:" token
+    char label[MAX];             // The label, without the ':'
+    int directive;               // One of the DIRECTIVE_* values, for LINE_DATA and LINE_EXTERN_ENTRY
+    char *arguments;             // Text after the directive or opcode name (points into the line)
+    const Opcode *opcode;        // The opcode descriptor, for LINE_OPCODE
+    char sourceOperand[MAX];     // Source operand, for two-operand opcodes
+    char targetOperand[MAX];     // Target operand (the only operand of one-operand opcodes)
+    int sourceMode;              // Addressing mode of the source operand, -1 if none or invalid
+    int targetMode;              // Addressing mode of the target operand, -1 if none or invalid
+} LineRecord;
+
+// A label operand whose word is patched once the symbol table is complete (single-pass mode)
+typedef struct Fixup {
+    NameId label;   // The label of the operand, without the '&'
+    int address;    // Address of the operand's word in the code image
+    int mode;       // DIRECT or RELATIVE
+} Fixup;
+
+// Forward references recorded by the first pass in single-pass mode
+typedef struct FixupList {
+    Fixup *fixups;        // Fixups in address order
+    int count;
+    int capacity;
+    char **entryLines;    // .entry lines, applied once all symbols are defined
+    int entryCount;
+    int entryCapacity;
+} FixupList;
+
+// Everything the assembler keeps while assembling one file. Each file gets its own
+// context, so files can be assembled concurrently on different threads
+typedef struct AssemblerContext {
+    Macro *macroTable;                          // Macro table (linked list of macros, in definition order)
+    MacroIndex macroIndex;                      // Hash index over the macro table
+    NamePool namePool;                          // Interned symbol names
+    Symbol *symbolTable;                        // Symbol table (linked list of symbols, in insertion order)
+    SymbolIndex symbolIndex;                    // Index over the symbol table by name id
+    EntryList entryList;                        // Symbols marked by .entry
+    CodeImage codeImage;                        // Instruction image (array of instruction words)
+    DataImage dataImage;                        // Data image (array of data words)
+    ExternalReference *externalReferencesList;  // List of external references
+    ExternalReference *externalReferencesTail;  // Last external reference, for O(1) appends
+    FixupList fixupList;                        // Forward references (single-pass mode)
+    SourceBuffer expandedSource;                // Pre-assembler output, read by both passes
+    Arena *arena;                               // Symbols, macros, references and temporary strings of the file
+    FileStats *stats;                           // Phase times and counters (--stats), NULL when disabled
+
+    int foundError;        // Error flag to indicate if any errors were found
+    int DC;                // Data counter
+    int IC;                // Instruction counter
+    int ICF;
+    int IDF;
+    int counter;           // Line counter
+    int singlePassMode;    // 1 to resolve label operands in the first pass, using fixups
+    int keepExpandedFile;  // 1 to also write the pre-assembler output to the .am file
+    int binaryOutput;      // 1 to also write the binary object file (.obj)
+    const char *cacheDir;  // Directory of the assembly cache, NULL if it is disabled
+    char cacheKey[17];     // Key of the source in the cache (see cache.h)
+
+    FILE *output;          // Where the messages about this file are printed
+    FILE *logOutput;       // Where the -v and -vv messages are printed, output unless it is captured
+    char *diagnostics;     // Messages captured for the cache while the file is assembled, NULL otherwise
+    size_t diagnosticsLength;
+    int logLevel;          // Highest LOG_* level printed
+    unsigned logCategories;  // LOG_* categories printed, errors are printed regardless
+} AssemblerContext;
+
+// A file waiting to be assembled by the worker pool (-j)
+typedef struct FileJob {
+    char *baseFile;     // Base file name, as given on the command line
+    long size;          // Size of the .asm file, larger files are started first
+    char *log;          // The messages printed while assembling the file
+    size_t logSize;
+    int succeeded;      // 1 if the file was assembled without errors
+    int done;           // 1 once a worker has finished the file
+} FileJob;
+
 // Function declarations
 
-// Opcode List management
-void insertOpcode(char *name, int value, int numOfOperands, int funct);
-void populateOpcodeList();
-Opcode *findOpcode(char *opcodeName);
+// Opcode table lookup
+const Opcode *findOpcode(const char *opcodeName);
+
+// Name hashing shared by the symbol and macro indexes
+unsigned long hashName(const char *name);
+
+// Name Pool management
+NameId internName(const char *name);
+NameId findName(const char *name);
+const char *nameText(NameId id);
+void freeNamePool();
 
 // Symbol Table management
-void insertSymbol(Symbol **head, char *name, int value, char properties[3][MAX]);
-void addSymbolToTable(char *name, int value, char *prop1, char *prop2, char *prop3);
-Symbol *findSymbol(char *symbolName);  
+void insertSymbol(Symbol **head, char *name, int value, unsigned attributes);
+void addSymbolToTable(char *name, int value, unsigned attributes);
+Symbol *findSymbol(const char *symbolName);
+Symbol *findSymbolById(NameId name);
+void freeSymbolTable();
+void printSymbolTableStats();
+
+// Entry List management
+void markEntrySymbol(Symbol *symbol);
+void freeEntryList();
 
 // Instruction List management
-void addInstruction(char *binaryInstruction, int L);
-void updateInstruction(int position, char *newInstruction);
+void addInstruction(Word instruction, int L);
+void updateInstruction(int position, Word newInstruction);
 void printInstructionList();
+void freeCodeImage();
 
 // Data List management
-void insertData(int value, int *DC, char *binaryOfInt);
+void insertData(int value, int *DC);
 void printDataList();
+void freeDataImage();
 void updateDataSymbols(Symbol *head);
 
+// Assembler Context management
+void initAssemblerContext(AssemblerContext *fileContext, FILE *output, Arena *arena, int singlePassMode, int keepExpandedFile);
+
+// Source Buffer management
+char *appendSourceLine(SourceBuffer *buffer, const char *text, size_t length);
+char *nextSourceLine(SourceBuffer *buffer, size_t *offset);
+void freeSourceBuffer(SourceBuffer *buffer);
+
+// Fixup List management (single-pass mode)
+void addFixup(NameId label, int address, int mode);
+void addEntryLine(const char *line);
+void freeFixupList();
+
 // External References management
-void addExternalReference(char *symbolName, int address);
+void addExternalReference(NameId symbol, int address);
 void printExternalReferences();
 
 #endif
@@ -0,0 +1,644 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include "disassembler.h"
+#include "assembler.h"
+#include "objectReader.h"
+
+// Opcode descriptor of every opcode/funct pair, NULL for pairs that no opcode encodes.
+// Opcodes without a funct encode funct 0
+static const Opcode *decodeTable[MAX_OPCODE_VALUE][MAX_FUNCT_VALUE];
+
+void buildDecodeTable() {
+    for (int i = 0; i < NUM_OF_OPCODES; i++) {
+        const Opcode *opcode = &opcodeTable[i];
+        decodeTable[opcode->value][(opcode->funct < 0) ? 0 : opcode->funct] = opcode;
+    }
+}
+
+// Sign-extends the 21-bit operand field of an extra word
+static int operandValue(Word word) {
+    int value = (int)((word >> OPERAND_SHIFT) & OPERAND_MASK);
+    return (value & 0x100000) ? value - 0x200000 : value;
+}
+
+// Sign-extends a 24-bit data word
+static int dataValue(Word word) {
+    int value = (int)(word & WORD_MASK);
+    return (value & 0x800000) ? value - 0x1000000 : value;
+}
+
+// Decodes the extra word of an operand (or the register of a register operand).
+// Returns 1 on success, 0 with a message in error otherwise
+static int decodeOperand(const ObjectImage *image, int mode, int reg, int *next, DecodedOperand *operand,
+                         char *error, size_t errorSize) {
+    int total = image->codeSize + image->dataSize;
+
+    operand->mode = mode;
+    operand->isExternal = 0;
+    operand->address = 0;
+
+    if (mode == REGISTER) {
+        operand->value = reg;
+        return 1;
+    }
+    if (reg != 0) {
+        snprintf(error, errorSize, "register field set for a non-register operand");
+        return 0;
+    }
+    if (*next >= image->codeSize) {
+        snprintf(error, errorSize, "operand word past the end of the code");
+        return 0;
+    }
+
+    int index = (*next)++;
+    Word word = image->words[index];
+    Word are = word & 7u;
+    operand->address = index + CODE_START_ADDRESS;
+
+    switch (mode) {
+        case IMMEDIATE:
+            operand->value = operandValue(word);
+            if (are != ARE_ABSOLUTE) {
+                snprintf(error, errorSize, "immediate operand without A bits");
+                return 0;
+            }
+            return 1;
+        case DIRECT:
+            if (are == ARE_EXTERNAL) {
+                operand->isExternal = 1;
+                operand->value = 0;
+                if ((word >> OPERAND_SHIFT) != 0) {
+                    snprintf(error, errorSize, "external operand with a value");
+                    return 0;
+                }
+                return 1;
+            }
+            operand->value = operandValue(word);
+            if (are != ARE_RELOCATABLE) {
+                snprintf(error, errorSize, "direct operand without R or E bits");
+                return 0;
+            }
+            break;
+        case RELATIVE:
+            if (are != ARE_ABSOLUTE) {
+                snprintf(error, errorSize, "relative operand without A bits");
+                return 0;
+            }
+            // The inverse of handleRelativeAddressing: distance = label - (position - 1)
+            operand->value = operandValue(word) + operand->address - 1;
+            break;
+    }
+
+    if (operand->value < CODE_START_ADDRESS || operand->value >= CODE_START_ADDRESS + total) {
+        snprintf(error, errorSize, "operand refers to address %d, outside the image", operand->value);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Decodes the instruction whose first word is at code index 'index'.
+ *
+ * Follows the layout of generateFirstWord: opcode (bits 23-18), source mode and register
+ * (bits 17-13), target mode and register (bits 12-8), funct (bits 7-3) and A,R,E (bits 2-0).
+ *
+ * @return int 1 on success, 0 with a message in error if the words are not a valid instruction.
+ */
+int decodeInstruction(const ObjectImage *image, int index, DecodedInstruction *instruction, char *error, size_t errorSize) {
+    Word word = image->words[index];
+    const Opcode *opcode = decodeTable[(word >> OPCODE_SHIFT) & 0x3F][(word >> FUNCT_SHIFT) & 0x1F];
+    int sourceMode = (word >> SOURCE_MODE_SHIFT) & 3;
+    int sourceReg = (word >> SOURCE_REG_SHIFT) & 7;
+    int targetMode = (word >> TARGET_MODE_SHIFT) & 3;
+    int targetReg = (word >> TARGET_REG_SHIFT) & 7;
+    int next = index + 1;
+
+    if (opcode == NULL || (word & 7u) != ARE_ABSOLUTE) {
+        snprintf(error, errorSize, "not an instruction word");
+        return 0;
+    }
+
+    instruction->opcode = opcode;
+    instruction->source.mode = -1;
+    instruction->target.mode = -1;
+
+    // Fields of operands that the opcode doesn't take are packed as zero
+    if (opcode->numOfOperands < 2 && (sourceMode != 0 || sourceReg != 0)) {
+        snprintf(error, errorSize, "source operand fields set for '%s'", opcode->name);
+        return 0;
+    }
+    if (opcode->numOfOperands < 1 && (targetMode != 0 || targetReg != 0)) {
+        snprintf(error, errorSize, "target operand fields set for '%s'", opcode->name);
+        return 0;
+    }
+
+    if (opcode->numOfOperands == 2) {
+        if (!(opcode->sourceModes & MODE_BIT(sourceMode))) {
+            snprintf(error, errorSize, "invalid source addressing mode %d for '%s'", sourceMode, opcode->name);
+            return 0;
+        }
+        if (!decodeOperand(image, sourceMode, sourceReg, &next, &instruction->source, error, errorSize)) {
+            return 0;
+        }
+    }
+    if (opcode->numOfOperands >= 1) {
+        if (!(opcode->targetModes & MODE_BIT(targetMode))) {
+            snprintf(error, errorSize, "invalid target addressing mode %d for '%s'", targetMode, opcode->name);
+            return 0;
+        }
+        if (!decodeOperand(image, targetMode, targetReg, &next, &instruction->target, error, errorSize)) {
+            return 0;
+        }
+    }
+
+    instruction->length = next - index;
+    return 1;
+}
+
+// Allocates the empty label, external and reference tables of an image whose words are read
+static void allocateTables(ObjectImage *image) {
+    int total = image->codeSize + image->dataSize;
+    image->labels = (const char **)calloc(total + 1, sizeof(char *));
+    image->externals = (const char **)calloc(total + 1, sizeof(char *));
+    image->referenced = (unsigned char *)calloc(total + 1, 1);
+    if (image->labels == NULL || image->externals == NULL || image->referenced == NULL) {
+        printf("Memory allocation error!\n");
+        exit(1);
+    }
+}
+
+// Reads an .ob file into an image with empty label and external tables
+int loadObjectImage(const char *fileName, ObjectImage *image) {
+    memset(image, 0, sizeof(ObjectImage));
+    image->labelPrefix = 'L';
+    image->externalPrefix = 'X';
+    if (!readObjectFile(fileName, &image->words, &image->codeSize, &image->dataSize)) {
+        return 0;
+    }
+    allocateTables(image);
+    return 1;
+}
+
+// Puts the names of an .ent or .ext file in labels (for .ent) or externals (for .ext), by address
+static void placeSymbols(const char *fileName, ObjectImage *image, const SymbolFile *symbols, const char **table) {
+    int total = image->codeSize + image->dataSize;
+
+    for (int i = 0; i < symbols->count; i++) {
+        const SymbolLine *line = &symbols->lines[i];
+        const char *name = line->name;
+
+        if (line->address < CODE_START_ADDRESS || line->address >= CODE_START_ADDRESS + total) {
+            printf("Warning: %s in %s is outside the image and is ignored\n", name, fileName);
+            continue;
+        }
+        if (table[line->address - CODE_START_ADDRESS] != NULL) {
+            printf("Warning: %s in %s shares address %d with %s and is ignored\n",
+                   name, fileName, line->address, table[line->address - CODE_START_ADDRESS]);
+            continue;
+        }
+        table[line->address - CODE_START_ADDRESS] = name;
+    }
+}
+
+// Marks the letter of every name of the form <letter><digits>, the names a generated one could clash with
+static void markGeneratedForms(const SymbolFile *symbols, unsigned char *taken) {
+    for (int i = 0; i < symbols->count; i++) {
+        const char *name = symbols->lines[i].name;
+        size_t length = strlen(name);
+        size_t digits = 1;
+        while (digits < length && isdigit((unsigned char)name[digits])) {
+            digits++;
+        }
+        if (length > 1 && digits == length) {
+            taken[(unsigned char)name[0]] = 1;
+        }
+    }
+}
+
+// Returns the first letter of 'candidates' that isn't taken, and takes it
+static char choosePrefix(const char *candidates, unsigned char *taken) {
+    for (const char *letter = candidates; *letter != '\0'; letter++) {
+        if (!taken[(unsigned char)*letter]) {
+            taken[(unsigned char)*letter] = 1;
+            return *letter;
+        }
+    }
+    printf("Warning: Every prefix is used by a symbol, generated names may clash\n");
+    return candidates[0];
+}
+
+/**
+ * @brief Chooses the prefixes of the generated label and extern names once every name
+ * of the .ent and .ext files is known, so the choice doesn't depend on their order.
+ *
+ * A prefix is never the letter of a name of the form <letter><digits>, and the
+ * two prefixes differ. 'r' is skipped, since r0-r7 are registers.
+ */
+static void choosePrefixes(ObjectImage *image) {
+    unsigned char taken[UCHAR_MAX + 1] = {0};
+
+    markGeneratedForms(&image->entryFile, taken);
+    markGeneratedForms(&image->externalFile, taken);
+    image->labelPrefix = choosePrefix("LMNOPQRSTUVWXYZABCDEFGHIJKabcdefghijklmnopqstuvwxyz", taken);
+    image->externalPrefix = choosePrefix("XYZABCDEFGHIJKLMNOPQRSTUVWabcdefghijklmnopqstuvwxyz", taken);
+}
+
+// Names the words after the entry and external symbols read in, and chooses the prefixes of the other names
+static void nameWords(ObjectImage *image, const char *entryFileName, const char *externalFileName) {
+    placeSymbols(entryFileName, image, &image->entryFile, image->labels);
+    placeSymbols(externalFileName, image, &image->externalFile, image->externals);
+    choosePrefixes(image);
+
+    // An entry name can't be declared .extern too, so a clash there is not possible
+    for (int i = 0; i < image->codeSize + image->dataSize; i++) {
+        if (image->labels[i] != NULL) {
+            image->referenced[i] |= LABEL_USE;
+        }
+    }
+}
+
+// Reads the entry names (.ent) and the external references (.ext) of an object, if present
+void readSymbolFiles(const char *baseFile, ObjectImage *image) {
+    char entryFileName[MAX];
+    char externalFileName[MAX];
+
+    snprintf(entryFileName, sizeof(entryFileName), "%s.ent", baseFile);
+    readSymbolFile(entryFileName, &image->entryFile);
+    snprintf(externalFileName, sizeof(externalFileName), "%s.ext", baseFile);
+    readSymbolFile(externalFileName, &image->externalFile);
+    nameWords(image, entryFileName, externalFileName);
+}
+
+// Reads a binary object (.obj) into an image, its entry and extern tables take the place of the .ent and .ext files
+int loadBinaryImage(const char *fileName, ObjectImage *image) {
+    memset(image, 0, sizeof(ObjectImage));
+    image->labelPrefix = 'L';
+    image->externalPrefix = 'X';
+    if (!readBinaryObjectFile(fileName, &image->words, &image->codeSize, &image->dataSize,
+                              &image->entryFile, &image->externalFile)) {
+        return 0;
+    }
+    allocateTables(image);
+    nameWords(image, fileName, fileName);
+    return 1;
+}
+
+// Records what an operand refers to: a word that needs a label, or an external use
+static void markReference(ObjectImage *image, const DecodedOperand *operand) {
+    if (operand->mode == DIRECT && operand->isExternal) {
+        image->referenced[operand->address - CODE_START_ADDRESS] |= EXTERNAL_USE;
+    } else if (operand->mode == DIRECT || operand->mode == RELATIVE) {
+        image->referenced[operand->value - CODE_START_ADDRESS] |= LABEL_USE;
+    }
+}
+
+// Writes the label of the word at 'address'
+static void printLabel(FILE *stream, const ObjectImage *image, int address) {
+    const char *name = image->labels[address - CODE_START_ADDRESS];
+    if (name != NULL) {
+        fputs(name, stream);
+    } else {
+        fprintf(stream, "%c%d", image->labelPrefix, address);
+    }
+}
+
+static void printOperand(FILE *stream, const ObjectImage *image, const DecodedOperand *operand) {
+    switch (operand->mode) {
+        case IMMEDIATE:
+            fprintf(stream, "#%d", operand->value);
+            break;
+        case DIRECT:
+            if (operand->isExternal) {
+                const char *name = image->externals[operand->address - CODE_START_ADDRESS];
+                if (name != NULL) {
+                    fputs(name, stream);
+                } else {
+                    // No .ext file, each use gets its own extern
+                    fprintf(stream, "%c%d", image->externalPrefix, operand->address);
+                }
+            } else {
+                printLabel(stream, image, operand->value);
+            }
+            break;
+        case RELATIVE:
+            fputc('&', stream);
+            printLabel(stream, image, operand->value);
+            break;
+        case REGISTER:
+            fprintf(stream, "r%d", operand->value);
+            break;
+    }
+}
+
+/**
+ * @brief Writes the recovered assembly source of an object image.
+ *
+ * Operands that refer to an address get a label on that word, named after the
+ * .ent file where possible. External operands use the names of the .ext file.
+ *
+ * @return int 1 on success, 0 if a code word is not a valid instruction.
+ */
+int printSource(FILE *stream, ObjectImage *image) {
+    DecodedInstruction instruction;
+    char error[MAX];
+    int total = image->codeSize + image->dataSize;
+
+    // Step 1: Decode the code once to find the addresses that need a label
+    for (int i = 0; i < image->codeSize; i += instruction.length) {
+        if (!decodeInstruction(image, i, &instruction, error, sizeof(error))) {
+            printf("Error: Address %d: %s (word %06x)\n", i + CODE_START_ADDRESS, error, image->words[i]);
+            return 0;
+        }
+        markReference(image, &instruction.source);
+        markReference(image, &instruction.target);
+    }
+
+    // Step 2: The .extern and .entry declarations, each external symbol is declared at its first use
+    int slotCount = 64;
+    while (slotCount < 2 * image->codeSize) {
+        slotCount *= 2;
+    }
+    const char **declared = (const char **)calloc(slotCount, sizeof(char *));
+    if (declared == NULL) {
+        printf("Memory allocation error!\n");
+        exit(1);
+    }
+    for (int i = 0; i < image->codeSize; i++) {
+        const char *name = image->externals[i];
+        if (!(image->referenced[i] & EXTERNAL_USE)) {
+            continue;
+        }
+        if (name == NULL) {
+            fprintf(stream, ".extern %c%d\n", image->externalPrefix, i + CODE_START_ADDRESS);
+            continue;
+        }
+        unsigned long slot = hashName(name) & (unsigned long)(slotCount - 1);
+        while (declared[slot] != NULL && strcmp(declared[slot], name) != 0) {
+            slot = (slot + 1) & (unsigned long)(slotCount - 1);  // Linear probing
+        }
+        if (declared[slot] == NULL) {
+            declared[slot] = name;
+            fprintf(stream, ".extern %s\n", name);
+        }
+    }
+    free(declared);
+    for (int i = 0; i < total; i++) {
+        if (image->labels[i] != NULL) {
+            fprintf(stream, ".entry %s\n", image->labels[i]);
+        }
+    }
+
+    // Step 3: The instructions, then the data one word per line
+    for (int i = 0; i < total; ) {
+        int address = i + CODE_START_ADDRESS;
+        if (image->referenced[i] & LABEL_USE) {
+            printLabel(stream, image, address);
+            fputs(": ", stream);
+        } else {
+            fputc(' ', stream);
+        }
+
+        if (i >= image->codeSize) {
+            fprintf(stream, ".data %d\n", dataValue(image->words[i]));
+            i++;
+            continue;
+        }
+
+        decodeInstruction(image, i, &instruction, error, sizeof(error));
+        fputs(instruction.opcode->name, stream);
+        if (instruction.source.mode >= 0) {
+            fputc(' ', stream);
+            printOperand(stream, image, &instruction.source);
+            fputc(',', stream);
+        }
+        if (instruction.target.mode >= 0) {
+            fputc(' ', stream);
+            printOperand(stream, image, &instruction.target);
+        }
+        fputc('\n', stream);
+        i += instruction.length;
+    }
+    return 1;
+}
+
+// Orders symbol lines by address, then by name
+static int compareSymbolLines(const void *a, const void *b) {
+    const SymbolLine *lineA = (const SymbolLine *)a;
+    const SymbolLine *lineB = (const SymbolLine *)b;
+
+    if (lineA->address != lineB->address) {
+        return (lineA->address < lineB->address) ? -1 : 1;
+    }
+    return strcmp(lineA->name, lineB->name);
+}
+
+// Returns a copy of the lines of a symbol file sorted by compareSymbolLines
+static SymbolLine *sortedSymbolLines(const SymbolFile *symbols) {
+    SymbolLine *lines = (SymbolLine *)malloc((symbols->count + 1) * sizeof(SymbolLine));
+    if (lines == NULL) {
+        printf("Memory allocation error!\n");
+        exit(1);
+    }
+    if (symbols->count > 0) {
+        memcpy(lines, symbols->lines, symbols->count * sizeof(SymbolLine));
+        qsort(lines, symbols->count, sizeof(SymbolLine), compareSymbolLines);
+    }
+    return lines;
+}
+
+/**
+ * @brief Compares the .ent or .ext content of the re-assembled source with the file read in.
+ *
+ * The assembler doesn't keep the order of the original source, so the lines are
+ * compared as sets. Prints each line found in only one of them.
+ *
+ * @return int The number of mismatching lines.
+ */
+static int compareSymbolFiles(const char *extension, const SymbolFile *expected, const char *text, size_t length) {
+    SymbolFile actual;
+    int mismatches = 0;
+
+    parseSymbolText(text, length, &actual);
+    SymbolLine *want = sortedSymbolLines(expected);
+    SymbolLine *got = sortedSymbolLines(&actual);
+
+    int i = 0, j = 0;
+    while (i < expected->count || j < actual.count) {
+        int order = (i == expected->count) ? 1
+                  : (j == actual.count) ? -1
+                  : compareSymbolLines(&want[i], &got[j]);
+        if (order == 0) {
+            i++;
+            j++;
+            continue;
+        }
+        if (mismatches < MAX_MISMATCHES) {
+            if (order < 0) {
+                printf("Mismatch: %s %d of the .%s file is not in the recovered source\n",
+                       want[i].name, want[i].address, extension);
+            } else {
+                printf("Mismatch: %s %d of the recovered source is not in the .%s file\n",
+                       got[j].name, got[j].address, extension);
+            }
+        }
+        if (order < 0) {
+            i++;
+        } else {
+            j++;
+        }
+        mismatches++;
+    }
+
+    free(want);
+    free(got);
+    freeSymbolFile(&actual);
+    return mismatches;
+}
+
+/**
+ * @brief Re-assembles the recovered source in memory and compares the words with the image,
+ * and the entries and external references with the .ent and .ext files that were read in.
+ *
+ * A missing .ent or .ext file is not compared, since the words were decoded without it.
+ *
+ * @return int 1 if everything matches, 0 otherwise.
+ */
+int verifyImage(ObjectImage *image) {
+    char *source = NULL;
+    size_t sourceSize = 0;
+    AssemblyResult result;
+    int mismatches = 0;
+
+    FILE *stream = open_memstream(&source, &sourceSize);
+    if (stream == NULL) {
+        printf("Memory allocation error!\n");
+        exit(1);
+    }
+    int decoded = printSource(stream, image);
+    fclose(stream);
+    if (!decoded) {
+        free(source);
+        return 0;
+    }
+
+    if (!assembleSource(source, sourceSize, 0, &result)) {
+        printf("Error: The recovered source does not assemble:\n%s", result.diagnostics);
+        freeAssemblyResult(&result);
+        free(source);
+        return 0;
+    }
+    free(source);
+
+    // Compare the counts line, then every word of the new object with the image
+    const char *p = result.object;
+    const char *end = result.object + result.objectSize;
+    long codeSize = 0, dataSize = 0;
+    parseNumber(&p, end, 10, &codeSize);
+    parseNumber(&p, end, 10, &dataSize);
+    if (codeSize != image->codeSize || dataSize != image->dataSize) {
+        printf("Mismatch: counts are %ld %ld, expected %d %d\n", codeSize, dataSize, image->codeSize, image->dataSize);
+        mismatches++;
+    }
+    for (int i = 0; i < image->codeSize + image->dataSize && p < end; i++) {
+        long address, word;
+        if (!parseNumber(&p, end, 10, &address) || !parseNumber(&p, end, 16, &word)) {
+            break;
+        }
+        if ((Word)word != image->words[i]) {
+            if (mismatches < MAX_MISMATCHES) {
+                printf("Mismatch at address %ld: %06lx, expected %06x\n", address, word, image->words[i]);
+            }
+            mismatches++;
+        }
+    }
+
+    if (image->entryFile.text != NULL) {
+        mismatches += compareSymbolFiles("ent", &image->entryFile, result.entries, result.entriesSize);
+    }
+    if (image->externalFile.text != NULL) {
+        mismatches += compareSymbolFiles("ext", &image->externalFile, result.externals, result.externalsSize);
+    }
+
+    freeAssemblyResult(&result);
+    if (mismatches > 0) {
+        printf("%d mismatches\n", mismatches);
+        return 0;
+    }
+    printf("Verified %d words\n", image->codeSize + image->dataSize);
+    return 1;
+}
+
+void freeObjectImage(ObjectImage *image) {
+    freeSymbolFile(&image->entryFile);
+    freeSymbolFile(&image->externalFile);
+    free(image->words);
+    free(image->labels);
+    free(image->externals);
+    free(image->referenced);
+    memset(image, 0, sizeof(ObjectImage));
+}
+
+// Disassembles <base>.ob (with <base>.ent and <base>.ext if present) to stdout,
+// or with --verify re-assembles the result and compares the words
+int main(int argc, char *argv[]) {
+    int verify = 0;
+    int binary = 0;
+    int failed = 0;
+    int numOfFiles = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--verify") == 0) {
+            verify = 1;
+        } else if (strcmp(argv[i], "-b") == 0 || strcmp(argv[i], "--binary") == 0) {
+            binary = 1;
+        } else if (argv[i][0] == '-') {
+            printf("Error: Unknown option '%s'.\n", argv[i]);
+            return 1;
+        } else {
+            numOfFiles++;
+        }
+    }
+    if (numOfFiles == 0) {
+        printf("Usage: %s [--verify] [-b] <object_file_1> ... <object_file_n>\n", argv[0]);
+        return 1;
+    }
+
+    buildDecodeTable();
+    for (int i = 1; i < argc; i++) {
+        char fileName[MAX];
+        ObjectImage image;
+
+        if (argv[i][0] == '-') {
+            continue;
+        }
+        if (binary) {
+            snprintf(fileName, sizeof(fileName), "%s.obj", argv[i]);
+            if (!loadBinaryImage(fileName, &image)) {
+                freeObjectImage(&image);
+                failed++;
+                continue;
+            }
+        } else {
+            snprintf(fileName, sizeof(fileName), "%s.ob", argv[i]);
+            if (!loadObjectImage(fileName, &image)) {
+                freeObjectImage(&image);
+                failed++;
+                continue;
+            }
+            readSymbolFiles(argv[i], &image);
+        }
+
+        if (verify) {
+            printf("%s: ", fileName);
+            fflush(stdout);
+        }
+        if (!(verify ? verifyImage(&image) : printSource(stdout, &image))) {
+            failed++;
+        }
+        freeObjectImage(&image);
+    }
+    return failed > 0;
+}
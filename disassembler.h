@@ -0,0 +1,56 @@
+#ifndef DISASSEMBLER_H
+#define DISASSEMBLER_H
+
+#include "globals.h"
+#include "bitUtils.h"
+#include "objectReader.h"
+
+#define MAX_OPCODE_VALUE 64  // The opcode field is 6 bits
+#define MAX_FUNCT_VALUE 32   // The funct field is 5 bits
+#define MAX_MISMATCHES 20    // Mismatching words listed by --verify
+
+// Flags of ObjectImage.referenced
+#define LABEL_USE 1     // An operand refers to the word, or it is an entry: it gets a label
+#define EXTERNAL_USE 2  // The word is the operand word of an external symbol
+
+// An object file read back into memory: code words followed by data words, from address 100
+typedef struct ObjectImage {
+    Word *words;
+    int codeSize;     // Number of code words (ICF - 100)
+    int dataSize;     // Number of data words (IDF)
+    const char **labels;  // Name of each word from the .ent file, NULL if it has none
+    unsigned char *referenced;  // LABEL_USE and EXTERNAL_USE flags of each word
+    char labelPrefix;     // Generated labels are this letter and the address
+    char externalPrefix;  // Externals without a .ext name are this letter and the address
+    SymbolFile entryFile;     // The .ent file, the labels point into it
+    SymbolFile externalFile;  // The .ext file, the externals point into it
+    const char **externals;  // Name of the external symbol used by each word, NULL if none
+} ObjectImage;
+
+// An operand recovered from its addressing mode and extra word
+typedef struct DecodedOperand {
+    int mode;       // Addressing mode, -1 if the opcode doesn't take this operand
+    int value;      // Immediate value, register number or target address
+    int isExternal; // 1 for a direct operand with E bits
+    int address;    // Address of the extra word, 0 for registers
+} DecodedOperand;
+
+// An instruction recovered from its first word
+typedef struct DecodedInstruction {
+    const Opcode *opcode;
+    DecodedOperand source;
+    DecodedOperand target;
+    int length;     // Number of words (L)
+} DecodedInstruction;
+
+void buildDecodeTable();
+int decodeInstruction(const ObjectImage *image, int index, DecodedInstruction *instruction, char *error, size_t errorSize);
+int loadObjectImage(const char *fileName, ObjectImage *image);
+void readSymbolFiles(const char *baseFile, ObjectImage *image);
+int loadBinaryImage(const char *fileName, ObjectImage *image);
+int printSource(FILE *stream, ObjectImage *image);
+int verifyImage(ObjectImage *image);
+void freeObjectImage(ObjectImage *image);
+int main(int argc, char *argv[]);
+
+#endif // DISASSEMBLER_H
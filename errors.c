@@ -1,7 +1,9 @@
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
 #include "error.h"
 #include "globals.h"
+#include "errors.h"
 
 // Function to raise and print an error message
 void raiseError(const char *format, ...) {
@@ -9,16 +11,46 @@ void raiseError(const char *format, ...) {
     va_start(args, format);
     
     // Set the foundError flag
-    foundError = 1;
+    context->foundError = 1;
     
     // Print the formatted error message
-    printf("Error: ");
-    vprintf(format, args);
-    printf("\n");
+    fprintf(context->output, "Error: ");
+    vfprintf(context->output, format, args);
+    fprintf(context->output, "\n");
 
     va_end(args);
 }
 
+// Parses a comma separated list of category names, returns 0 if a name is unknown
+unsigned parseLogCategories(const char *list) {
+    static const char *names[] = {"driver", "pre", "first", "second", "tables", "parse", NULL};
+    unsigned categories = 0;
+
+    while (*list != '\0') {
+        size_t length = strcspn(list, ",");
+        int found = 0;
+
+        for (int i = 0; names[i] != NULL; i++) {
+            if (strlen(names[i]) == length && strncmp(list, names[i], length) == 0) {
+                categories |= 1u << i;  // Same order as the LOG_* category bits
+                found = 1;
+            }
+        }
+        if (strncmp(list, "all", length) == 0 && length == 3) {
+            categories |= LOG_ALL;
+            found = 1;
+        }
+        if (!found) {
+            return 0;
+        }
+        list += length;
+        if (*list == ',') {
+            list++;
+        }
+    }
+    return categories;
+}
+
 void raiseErrorPreAssembler(){
 
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -4,4 +4,39 @@
 // Function declaration for raiseError
 void raiseError(const char *format, ...);
 
+// Log levels. Errors are always printed, the other messages only up to the context's logLevel
+#define LOG_ERROR 0  // Errors only, the default
+#define LOG_INFO 1   // Progress of each file (-v)
+#define LOG_DEBUG 2  // Traces of the passes and the tables (-vv)
+
+// Highest level compiled in. Build with -DLOG_MAX_LEVEL=LOG_INFO (or LOG_ERROR) to compile the traces out
+#ifndef LOG_MAX_LEVEL
+#define LOG_MAX_LEVEL LOG_DEBUG
+#endif
+
+// Log categories, one bit per subsystem
+#define LOG_DRIVER (1u << 0)  // File handling and output files
+#define LOG_PRE (1u << 1)     // Pre-assembler
+#define LOG_FIRST (1u << 2)   // First pass
+#define LOG_SECOND (1u << 3)  // Second pass and fixups
+#define LOG_TABLES (1u << 4)  // Symbol table, code and data images
+#define LOG_PARSE (1u << 5)   // Operand, symbol and data parsing
+#define LOG_ALL 0x3fu
+
+// 1 if messages of this level and category are printed. A level above LOG_MAX_LEVEL
+// is a constant 0, otherwise the check is a single branch on the context
+#define logEnabled(level, category) \
+    ((level) <= LOG_MAX_LEVEL && (level) <= context->logLevel && (context->logCategories & (category)))
+
+// Prints a message to the context's log output if its level and category are enabled
+#define logMessage(level, category, ...) \
+    do { \
+        if (logEnabled(level, category)) { \
+            fprintf(context->logOutput, __VA_ARGS__); \
+        } \
+    } while (0)
+
+// Parses a comma separated list of category names, returns 0 if a name is unknown
+unsigned parseLogCategories(const char *list);
+
 #endif // ERROR_H
@@ -9,25 +9,25 @@
 
 // Function declarations
 
-// Function that runs the first pass
-int firstPass(char *filename);
+// Function that runs the first pass over the source expanded by the pre-assembler
+int firstPass(SourceBuffer *source);
 
 /*
 // Function to update data symbols in the symbol table after the first pass
 void updateDataSymbols(Symbol *head, int ICF);
 */
 
-// Function to determine the line type
-int determineLineType(char *line);
+// Function to tokenize a line once into a line record, returns the line type
+int parseLine(char *line, LineRecord *record);
 
 // Function to process a line from the source file
 void processLine(char *line, int *IC, int *DC);  // Pass IC and DC by reference
 
-// Function to generate the first word of machine code as a binary string
-char *generateFirstWord(Opcode *opcode, int mode1, int mode2, int registerNum1, int registerNum2);
+// Function to generate the first word of machine code as a packed word
+Word generateFirstWord(const Opcode *opcode, int mode1, int mode2, int registerNum1, int registerNum2);
 
 // Function to find the addressing mode of an operand
-int findAddressingMode(char *operand);
+int findAddressingMode(const char *operand);
 
 /*
 // Function to raise an error message
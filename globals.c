@@ -7,21 +7,10 @@
 #include <string.h>
 #include <ctype.h>
 
-// Linked list for opcodes
-Opcode *opcodeList = NULL;
-Symbol *symbolTable = NULL;
-Macro *macroTable = NULL;  // Head of the Macros table
-InstructionNode *instructionList = NULL; // Head of the instruction list (global)
-DataNode *dataList = NULL;  // Head of the linked list
-ExternalReference *externalReferencesList = NULL;  // Head of the external references list
+// The per-file state (tables, images, IC, DC, etc.) lives in an AssemblerContext,
+// each thread points at the context of the file it is assembling
+__thread AssemblerContext *context = NULL;
 
-// Define other global variables (IC, DC, etc.)
-int IC = 0;
-int DC = 0;
-int foundError = 0;
-int counter;
-int ICF;
-int IDF;
 const char *reservedWords[] = {
     "mov", "cmp", "add", "sub", "not", "clr", "lea", "inc", "dec", 
     "jmp", "bne", "red", "prn", "jsr", "rts", "stop", 
@@ -32,23 +21,28 @@ const char *registerNames[] = {
     "r0", "r1", "r2", "r3", "r4", "r5", "r6", "r7", NULL
 };
 
-// Array to store valid addressing modes for each opcode
-OpcodeAddressingModes validAddressingModes[] = {
-    {"mov", {0, 1, 3, -1}, {1, 3, -1, -1}},  // Source: 0, 1, 3; Target: 1, 3
-    {"cmp", {0, 1, 3, -1}, {0, 1, 3, -1}},  // Source: 0, 1, 3; Target: 0, 1, 3
-    {"add", {0, 1, 3, -1}, {1, 3, -1, -1}},  // Source: 0, 1, 3; Target: 1, 3
-    {"sub", {0, 1, 3, -1}, {1, 3, -1, -1}},  // Source: 0, 1, 3; Target: 1, 3
-    {"lea", {1, -1, -1, -1}, {1, 3, -1, -1}},  // Source: 1; Target: 1, 3
-    {"clr", {-1, -1, -1, -1}, {1, 3, -1, -1}},  // No source; Target: 1, 3
-    {"not", {-1, -1, -1, -1}, {1, 3, -1, -1}},  // No source; Target: 1, 3
-    {"inc", {-1, -1, -1, -1}, {1, 3, -1, -1}},  // No source; Target: 1, 3
-    {"dec", {-1, -1, -1, -1}, {1, 3, -1, -1}},  // No source; Target: 1, 3
-    {"jmp", {-1, -1, -1, -1}, {1, 2, -1, -1}},  // No source; Target: 1, 2
-    {"bne", {-1, -1, -1, -1}, {1, 2, -1, -1}},  // No source; Target: 1, 2
-    {"jsr", {-1, -1, -1, -1}, {1, 2, -1, -1}},  // No source; Target: 1, 2
-    {"red", {-1, -1, -1, -1}, {1, 3, -1, -1}},  // No source; Target: 1, 3
-    {"prn", {-1, -1, -1, -1}, {0, 1, 3, -1}},  // No source; Target: 0, 1, 3
-    {"rts", {-1, -1, -1, -1}, {-1, -1, -1, -1}},  // No source; No target
-    {"stop", {-1, -1, -1, -1}, {-1, -1, -1, -1}}  // No source; No target
-};
+#define SRC_ALL (MODE_BIT(IMMEDIATE) | MODE_BIT(DIRECT) | MODE_BIT(REGISTER))
+#define TGT_RW (MODE_BIT(DIRECT) | MODE_BIT(REGISTER))
+#define TGT_JUMP (MODE_BIT(DIRECT) | MODE_BIT(RELATIVE))
+#define FIRST_WORD(value, funct) (PACK_OPCODE(value) | PACK_FUNCT(funct) | ARE_ABSOLUTE)
 
+// Opcode descriptors: name, value, number of operands, funct (-1 if none),
+// valid source modes, valid target modes and the pre-encoded first word
+const Opcode opcodeTable[NUM_OF_OPCODES] = {
+    {"mov",  0,  2, -1, SRC_ALL,           TGT_RW,                       FIRST_WORD(0, -1)},
+    {"cmp",  1,  2, -1, SRC_ALL,           SRC_ALL,                      FIRST_WORD(1, -1)},
+    {"add",  2,  2,  1, SRC_ALL,           TGT_RW,                       FIRST_WORD(2, 1)},
+    {"sub",  2,  2,  2, SRC_ALL,           TGT_RW,                       FIRST_WORD(2, 2)},
+    {"lea",  4,  2, -1, MODE_BIT(DIRECT),  TGT_RW,                       FIRST_WORD(4, -1)},
+    {"clr",  5,  1,  1, 0,                 TGT_RW,                       FIRST_WORD(5, 1)},
+    {"not",  5,  1,  2, 0,                 TGT_RW,                       FIRST_WORD(5, 2)},
+    {"inc",  5,  1,  3, 0,                 TGT_RW,                       FIRST_WORD(5, 3)},
+    {"dec",  5,  1,  4, 0,                 TGT_RW,                       FIRST_WORD(5, 4)},
+    {"jmp",  9,  1,  1, 0,                 TGT_JUMP,                     FIRST_WORD(9, 1)},
+    {"bne",  9,  1,  2, 0,                 TGT_JUMP,                     FIRST_WORD(9, 2)},
+    {"jsr",  9,  1,  3, 0,                 TGT_JUMP,                     FIRST_WORD(9, 3)},
+    {"red",  12, 1, -1, 0,                 TGT_RW,                       FIRST_WORD(12, -1)},
+    {"prn",  13, 1, -1, 0,                 SRC_ALL,                      FIRST_WORD(13, -1)},
+    {"rts",  14, 0, -1, 0,                 0,                            FIRST_WORD(14, -1)},
+    {"stop", 15, 0, -1, 0,                 0,                            FIRST_WORD(15, -1)}
+};
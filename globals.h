@@ -3,7 +3,8 @@
 
 #define MAX 80
 #define MAX_SYMBOL_LENGTH 31
-#define BINARY_LENGTH 25
+
+#define ASSEMBLER_VERSION "1.3"  // Part of the cache key, change it when the output format changes
 
 // Include the full structure definitions from dataStructures.h
 #include "dataStructures.h"
@@ -14,24 +15,16 @@
 #define RELATIVE 2      // Relative addressing (&label)
 #define REGISTER 3   // Direct register addressing (r0-r7)
 
+#define MODE_BIT(mode) (1u << (mode))  // Bit of an addressing mode in an opcode's mode bitmask
+#define NUM_OF_OPCODES 16
+
 // Declare global variables as extern
 
+// The state of the file being assembled by the current thread (tables, images, counters)
+extern __thread AssemblerContext *context;
+
 // Typedef-based variables
-extern Macro *macroTable;                // Macro table (linked list of macros)
-extern Symbol *symbolTable;              // Symbol table (linked list of symbols)
-extern Opcode *opcodeList;               // Linked list of opcodes
-extern InstructionNode *instructionList; // Linked list of instruction words
-extern DataNode *dataList;               // Linked list of data words
-extern OpcodeAddressingModes validAddressingModes[]; // Valid addressing modes for opcodes
-extern ExternalReference *externalReferencesList;    // List of external references
-
-// Integers
-extern int foundError;   // Error flag to indicate if any errors were found
-extern int DC;           // Data counter
-extern int IC;           // Instruction counter
-extern int ICF;
-extern int IDF;
-extern int counter;      // Line counter
+extern const Opcode opcodeTable[NUM_OF_OPCODES];     // Opcode descriptors, with their valid addressing modes
 
 // Character pointers
 extern const char *registerNames[];      // List of register names (e.g., "r0" to "r7")
@@ -0,0 +1,311 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "linker.h"
+#include "outputWriter.h"
+#include "cache.h"
+
+// Maps an address of a module (as assembled, from 100) to its address in the linked image.
+// Code addresses move with the module's code, data addresses with the module's data
+int relocateAddress(const Module *module, int address) {
+    int index = address - CODE_START_ADDRESS;
+
+    if (index < module->codeSize) {
+        return module->codeBase + index;
+    }
+    return module->dataBase + (index - module->codeSize);
+}
+
+// Returns the slot holding 'name', or the empty slot where it would be inserted
+GlobalSymbol *findGlobalSlot(GlobalTable *table, const char *name) {
+    unsigned long mask = (unsigned long)table->capacity - 1;
+    unsigned long i = hashName(name) & mask;
+
+    while (table->slots[i].name != NULL && strcmp(table->slots[i].name, name) != 0) {
+        i = (i + 1) & mask;  // Linear probing
+    }
+    return &table->slots[i];
+}
+
+// Reads <base>.ob, and <base>.ent and <base>.ext if they exist
+int loadModule(const char *baseFile, Module *module) {
+    char fileName[MAX];
+
+    memset(module, 0, sizeof(Module));
+    module->baseFile = baseFile;
+
+    snprintf(fileName, sizeof(fileName), "%s.ob", baseFile);
+    if (!readObjectFile(fileName, &module->words, &module->codeSize, &module->dataSize)) {
+        return 0;
+    }
+    snprintf(fileName, sizeof(fileName), "%s.ent", baseFile);
+    readSymbolFile(fileName, &module->entries);
+    snprintf(fileName, sizeof(fileName), "%s.ext", baseFile);
+    readSymbolFile(fileName, &module->externals);
+    return 1;
+}
+
+// Opens a memory stream for the content of an output file
+static FILE *openOutputBuffer(char **data, size_t *length) {
+    FILE *stream = open_memstream(data, length);
+    if (stream == NULL) {
+        printf("Memory allocation error!\n");
+        exit(1);
+    }
+    return stream;
+}
+
+// Writes <outputBase>.<extension> from its content in memory, like the assembler's outputs:
+// a file that already holds the content is left untouched
+static int saveLinkedFile(const char *outputBase, const char *extension, const char *description,
+                          char *data, size_t length) {
+    char fileName[MAX];
+    snprintf(fileName, sizeof(fileName), "%s.%s", outputBase, extension);
+
+    int written = writeIfChanged(fileName, data, length);
+    free(data);
+    if (written < 0) {
+        printf("Error: Unable to create %s file: %s\n", description, fileName);
+        return 0;
+    }
+    return 1;
+}
+
+// Writes the linked image as an object file, and the relocated entries as an entry file
+static int writeLinkedFiles(const char *outputBase, const Word *image, int codeSize, int dataSize,
+                            const Module *modules, int numOfModules) {
+    char header[32];
+    OutputBuffer buffer;
+    char *data;
+    size_t length;
+
+    FILE *obFile = openOutputBuffer(&data, &length);
+    initOutputBuffer(&buffer, obFile);
+    int headerLength = snprintf(header, sizeof(header), "%d %d\n", codeSize, dataSize);
+    appendText(&buffer, header, (size_t)headerLength);
+    for (int i = 0; i < codeSize + dataSize; i++) {
+        appendObjectLine(&buffer, CODE_START_ADDRESS + i, image[i]);
+    }
+    flushOutputBuffer(&buffer);
+    fclose(obFile);
+    if (!saveLinkedFile(outputBase, "ob", "object", data, length)) {
+        return 0;
+    }
+
+    int entryCount = 0;
+    for (int m = 0; m < numOfModules; m++) {
+        entryCount += modules[m].entries.count;
+    }
+    if (entryCount == 0) {
+        return 1;
+    }
+
+    FILE *entFile = openOutputBuffer(&data, &length);
+    initOutputBuffer(&buffer, entFile);
+    for (int m = 0; m < numOfModules; m++) {
+        for (int i = 0; i < modules[m].entries.count; i++) {
+            const SymbolLine *line = &modules[m].entries.lines[i];
+            appendSymbolLine(&buffer, line->name, relocateAddress(&modules[m], line->address));
+        }
+    }
+    flushOutputBuffer(&buffer);
+    fclose(entFile);
+    return saveLinkedFile(outputBase, "ent", "entry", data, length);
+}
+
+/**
+ * @brief Links assembled modules into one image.
+ *
+ * The code of all modules comes first, in command line order, followed by their data.
+ * Relocatable (R) words are moved with the segment they point into, and every
+ * external (E) word listed in a module's .ext file is rewritten into an R word
+ * pointing at the symbol exported by another module's .ent file.
+ * Duplicate and undefined symbols, and E words that no .ext line lists, are all
+ * reported before giving up.
+ *
+ * @return int 1 if the image was linked and written, 0 on errors.
+ */
+int linkModules(Module *modules, int numOfModules, const char *outputBase) {
+    GlobalTable table;
+    int codeSize = 0, dataSize = 0, symbolCount = 0;
+    int errors = 0;
+
+    // Step 1: Lay out the code segments, then the data segments
+    for (int m = 0; m < numOfModules; m++) {
+        modules[m].codeBase = CODE_START_ADDRESS + codeSize;
+        codeSize += modules[m].codeSize;
+        symbolCount += modules[m].entries.count + modules[m].externals.count;
+    }
+    for (int m = 0; m < numOfModules; m++) {
+        modules[m].dataBase = CODE_START_ADDRESS + codeSize + dataSize;
+        dataSize += modules[m].dataSize;
+    }
+
+    // Step 2: Build the global table from the exports, the load factor stays at most 1/2
+    table.capacity = 64;
+    while (table.capacity < 2 * symbolCount) {
+        table.capacity *= 2;
+    }
+    table.count = 0;
+    table.slots = (GlobalSymbol *)calloc(table.capacity, sizeof(GlobalSymbol));
+    if (table.slots == NULL) {
+        printf("Memory allocation error!\n");
+        exit(1);
+    }
+
+    for (int m = 0; m < numOfModules; m++) {
+        for (int i = 0; i < modules[m].entries.count; i++) {
+            const SymbolLine *line = &modules[m].entries.lines[i];
+            GlobalSymbol *symbol = findGlobalSlot(&table, line->name);
+
+            if (symbol->name != NULL) {
+                printf("Error: Symbol '%s' is exported by both %s and %s\n",
+                       line->name, modules[symbol->module].baseFile, modules[m].baseFile);
+                errors++;
+                continue;
+            }
+            symbol->name = line->name;
+            symbol->address = relocateAddress(&modules[m], line->address);
+            symbol->module = m;
+            table.count++;
+        }
+    }
+
+    // Step 3: Copy the segments, moving the R words of the code with their targets
+    Word *image = (Word *)malloc((codeSize + dataSize + 1) * sizeof(Word));
+    unsigned char *listed = (unsigned char *)calloc(codeSize + 1, 1);  // E words named by a .ext line
+    if (image == NULL || listed == NULL) {
+        printf("Memory allocation error!\n");
+        exit(1);
+    }
+    for (int m = 0; m < numOfModules; m++) {
+        Module *module = &modules[m];
+        Word *code = image + (module->codeBase - CODE_START_ADDRESS);
+
+        for (int i = 0; i < module->codeSize; i++) {
+            Word word = module->words[i];
+            // Only direct operand words carry R bits, first words and other operands are absolute
+            if ((word & 7u) == ARE_RELOCATABLE) {
+                int target = (int)((word >> OPERAND_SHIFT) & OPERAND_MASK);
+                word = PACK_OPERAND(relocateAddress(module, target), ARE_RELOCATABLE);
+            }
+            code[i] = word;
+        }
+        memcpy(image + (module->dataBase - CODE_START_ADDRESS), module->words + module->codeSize,
+               module->dataSize * sizeof(Word));
+    }
+
+    // Step 4: Resolve the external references, undefined names are counted once each
+    for (int m = 0; m < numOfModules; m++) {
+        Module *module = &modules[m];
+
+        for (int i = 0; i < module->externals.count; i++) {
+            const SymbolLine *line = &module->externals.lines[i];
+            int index = line->address - CODE_START_ADDRESS;
+
+            if (index < 0 || index >= module->codeSize || module->words[index] != ARE_EXTERNAL) {
+                printf("Error: %s.ext lists '%s' at %d, which is not an external operand word\n",
+                       module->baseFile, line->name, line->address);
+                errors++;
+                continue;
+            }
+
+            GlobalSymbol *symbol = findGlobalSlot(&table, line->name);
+            if (symbol->name == NULL) {
+                symbol->name = line->name;  // First reference to an undefined name
+                symbol->module = -1;
+                symbol->firstReference = m;
+                table.count++;
+            }
+            listed[module->codeBase - CODE_START_ADDRESS + index] = 1;
+            if (symbol->module < 0) {
+                symbol->references++;
+                continue;
+            }
+            image[module->codeBase - CODE_START_ADDRESS + index] = PACK_OPERAND(symbol->address, ARE_RELOCATABLE);
+        }
+    }
+
+    // An E word that no .ext line names can't be resolved, for example when the .ext file is missing
+    for (int m = 0; m < numOfModules; m++) {
+        Module *module = &modules[m];
+
+        for (int i = 0; i < module->codeSize; i++) {
+            if ((module->words[i] & 7u) == ARE_EXTERNAL && !listed[module->codeBase - CODE_START_ADDRESS + i]) {
+                printf("Error: Undefined external reference at %d in %s, not listed in %s.ext\n",
+                       CODE_START_ADDRESS + i, module->baseFile, module->baseFile);
+                errors++;
+            }
+        }
+    }
+
+    for (int i = 0; i < table.capacity; i++) {
+        GlobalSymbol *symbol = &table.slots[i];
+        if (symbol->name != NULL && symbol->module < 0) {
+            printf("Error: Undefined symbol '%s' (%d references, first in %s)\n",
+                   symbol->name, symbol->references, modules[symbol->firstReference].baseFile);
+            errors++;
+        }
+    }
+
+    // Step 5: Write the linked image only if everything was resolved
+    if (errors == 0) {
+        if (!writeLinkedFiles(outputBase, image, codeSize, dataSize, modules, numOfModules)) {
+            errors++;
+        }
+    } else {
+        printf("%d errors, %s.ob not written\n", errors, outputBase);
+    }
+
+    free(image);
+    free(listed);
+    free(table.slots);
+    return errors == 0;
+}
+
+// Links <base>.ob files (with their .ent and .ext) into <output>.ob and <output>.ent
+int main(int argc, char *argv[]) {
+    const char *outputBase = "linked";
+    Module *modules;
+    int numOfModules = 0;
+    int loaded = 1;
+
+    modules = (Module *)malloc(argc * sizeof(Module));
+    if (modules == NULL) {
+        printf("Memory allocation error!\n");
+        return 1;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0) {
+            if (i + 1 >= argc) {
+                printf("Error: '-o' expects an output name.\n");
+                free(modules);
+                return 1;
+            }
+            outputBase = argv[++i];
+        } else if (argv[i][0] == '-') {
+            printf("Error: Unknown option '%s'.\n", argv[i]);
+            free(modules);
+            return 1;
+        } else if (!loadModule(argv[i], &modules[numOfModules++])) {
+            loaded = 0;
+        }
+    }
+
+    if (numOfModules == 0) {
+        printf("Usage: %s [-o output] <module_1> <module_2> ... <module_n>\n", argv[0]);
+        free(modules);
+        return 1;
+    }
+
+    int linked = loaded && linkModules(modules, numOfModules, outputBase);
+
+    for (int m = 0; m < numOfModules; m++) {
+        free(modules[m].words);
+        freeSymbolFile(&modules[m].entries);
+        freeSymbolFile(&modules[m].externals);
+    }
+    free(modules);
+    return linked ? 0 : 1;
+}
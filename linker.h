@@ -0,0 +1,42 @@
+#ifndef LINKER_H
+#define LINKER_H
+
+#include "globals.h"
+#include "bitUtils.h"
+#include "objectReader.h"
+
+// An assembled module: its .ob words and its .ent and .ext files
+typedef struct Module {
+    const char *baseFile;     // Base file name, as given on the command line
+    Word *words;              // Code words followed by data words
+    int codeSize;
+    int dataSize;
+    int codeBase;             // Address of the module's first code word in the linked image
+    int dataBase;             // Address of the module's first data word in the linked image
+    SymbolFile entries;
+    SymbolFile externals;
+} Module;
+
+// An exported (.ent) symbol of the global table, or an undefined name that was referenced
+typedef struct GlobalSymbol {
+    const char *name;
+    int address;              // Address in the linked image
+    int module;               // Index of the defining module, -1 for an undefined name
+    int references;           // Number of references to an undefined name
+    int firstReference;       // Module of the first reference to an undefined name
+} GlobalSymbol;
+
+// Open-addressing hash table over the global symbols
+typedef struct GlobalTable {
+    GlobalSymbol *slots;      // Hash slots (linear probing), a NULL name marks an empty slot
+    int capacity;             // Number of slots, always a power of two
+    int count;
+} GlobalTable;
+
+int relocateAddress(const Module *module, int address);
+GlobalSymbol *findGlobalSlot(GlobalTable *table, const char *name);
+int loadModule(const char *baseFile, Module *module);
+int linkModules(Module *modules, int numOfModules, const char *outputBase);
+int main(int argc, char *argv[]);
+
+#endif // LINKER_H
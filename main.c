@@ -5,277 +5,473 @@
 #include "errors.h"
 #include "main.h"
 #include "bitUtils.h"
+#include "objectFile.h"
+#include "cache.h"
+#include "stats.h"
 #include <stdio.h>
-
-// Function to create the .ob object file
-void createObjectFile(char *baseFile) {
-    char obFileName[MAX];
-    snprintf(obFileName, sizeof(obFileName), "%s.ob", baseFile);
-
-    FILE *obFile = fopen(obFileName, "w");
-    if (obFile == NULL) {
-        raiseError("Error: Unable to create object file: %s\n", obFileName);
-        return;
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+// Opens a memory stream for the content of an output file
+static FILE *openOutputBuffer(char **data, size_t *length) {
+    FILE *stream = open_memstream(data, length);
+    if (stream == NULL) {
+        fprintf(context->output, "Memory allocation error!\n");
+        exit(1);
     }
+    return stream;
+}
 
-    // Write the first line: instruction count and data count
-    fprintf(obFile, "%d %d\n", ICF - 100, IDF);
-
-    // Write the instructions
-    InstructionNode *currentInstruction = instructionList;
-    int address = currentInstruction->Address;
-    while (currentInstruction != NULL) {
-        char *hexValue = binaryToHexString(currentInstruction->instruction);
-        fprintf(obFile, "%07d %s\n", currentInstruction->Address, hexValue);
-        free(hexValue); // Free allocated memory for hexadecimal string
-        currentInstruction = currentInstruction->next;
-        address++;
-    }
+// Writes <baseFile>.<extension> from its content in memory, leaving the file untouched
+// if it already holds that content, and keeps a copy in the cache when it is enabled
+static void saveOutputFile(char *baseFile, const char *extension, const char *description, char *data, size_t length) {
+    char fileName[MAX];
+    snprintf(fileName, sizeof(fileName), "%s.%s", baseFile, extension);
 
-    // Write the data
-    DataNode *currentData = dataList;
-    while (currentData != NULL) {
-        char *hexValue = binaryToHexString(currentData->binaryRep);
-        fprintf(obFile, "%07d %s\n", address, hexValue);
-        free(hexValue); // Free allocated memory for hexadecimal string
-        currentData = currentData->next;
-        address++;
+    int written = writeIfChanged(fileName, data, length);
+    if (written < 0) {
+        raiseError("Error: Unable to create %s file: %s\n", description, fileName);
+    } else {
+        if (context->cacheDir != NULL) {
+            storeInCache(context->cacheDir, context->cacheKey, extension, data, length);
+        }
+        logMessage(LOG_INFO, LOG_DRIVER, written ? "%s file created: %s\n" : "%s file unchanged: %s\n", description, fileName);
     }
+    free(data);
+}
 
+// Function to create the .ob object file
+void createObjectFile(char *baseFile) {
+    char *data;
+    size_t length;
+    FILE *obFile = openOutputBuffer(&data, &length);
+
+    writeObject(obFile);
     fclose(obFile);
-    printf("Object file created: %s\n", obFileName);
+    saveOutputFile(baseFile, "ob", "Object", data, length);
 }
 
-void createEntryFile(char *baseFile) {
-    char entFileName[MAX];
-    snprintf(entFileName, sizeof(entFileName), "%s.ent", baseFile);
-    
-    FILE *entFile = fopen(entFileName, "w");
-    if (entFile == NULL) {
-        raiseError("Error: Unable to create entry file: %s\n", entFileName);
-        return;
-    }
+// Function to create the .obj binary object file
+void createBinaryObjectFile(char *baseFile) {
+    char *data;
+    size_t length;
+    FILE *objFile = openOutputBuffer(&data, &length);
 
-    Symbol *current = symbolTable;  // Traverse the symbol table to find entry symbols
-    int entriesFound = 0;
+    writeBinaryObject(objFile);
+    fclose(objFile);
+    saveOutputFile(baseFile, "obj", "Binary object", data, length);
+}
 
-    while (current != NULL) {
-        // Check if the symbol has the 'entry' property
-        printf("printing inside createEntries - current symbol: %s\n", current->name);
-        if (strcmp(current->properties[2], "entry") == 0) {
-            // Write the symbol name and its value in 7-digit format
-            fprintf(entFile, "%s %07d\n", current->name, current->value);
-            entriesFound++;
-        }
-        current = current->next;
-    }
+void createEntryFile(char *baseFile) {
+    char *data;
+    size_t length;
+    FILE *entFile = openOutputBuffer(&data, &length);
 
+    int entriesFound = writeEntries(entFile);
     fclose(entFile);
 
     if (entriesFound > 0) {
-        printf("Entry file created: %s\n", entFileName);
+        saveOutputFile(baseFile, "ent", "Entry", data, length);
     } else {
-        // No entry symbols found, so delete the file
-        remove(entFileName);
-        printf("No entry symbols found. Entry file not created.\n");
+        free(data);
+        logMessage(LOG_INFO, LOG_DRIVER, "No entry symbols found. Entry file not created.\n");
     }
 }
 
 void createExternalFile(char *baseFile) {
-    char extFileName[MAX];
-    snprintf(extFileName, sizeof(extFileName), "%s.ext", baseFile);
+    char *data;
+    size_t length;
+    FILE *extFile = openOutputBuffer(&data, &length);
 
-    FILE *extFile = fopen(extFileName, "w");
-    if (extFile == NULL) {
-        raiseError("Error: Unable to create external file: %s\n", extFileName);
-        return;
-    }
+    // Write each external reference to the file
+    writeExternals(extFile);
+    fclose(extFile);
+    saveOutputFile(baseFile, "ext", "External", data, length);
+}
 
-    // Traverse the external references list and write each entry to the file
-    ExternalReference *current = externalReferencesList;
-    while (current != NULL) {
-        // Write the symbol name and its address to the file
-        fprintf(extFile, "%s %07d\n", current->symbolName, current->address);
-        current = current->next;  // Move to the next external reference
+// Keeps the messages printed so far in the cache, so a cache hit prints them again.
+// Called before the .ob is stored, which completes the entry
+static void storeDiagnostics() {
+    if (context->cacheDir == NULL || context->output == context->logOutput) {
+        return;  // The messages aren't captured
+    }
+    fflush(context->output);  // Sets diagnostics and diagnosticsLength
+    if (context->diagnosticsLength > 0) {
+        storeInCache(context->cacheDir, context->cacheKey, CACHE_LOG_EXTENSION, context->diagnostics,
+                     context->diagnosticsLength);
     }
-
-    fclose(extFile);
-    printf("External file created: %s\n", extFileName);
 }
 
-int main(int argc, char *argv[]) {
-    // Step 0: Populate the opcode list
-    populateOpcodeList();
+// Runs the pre-assembler, the passes and the output steps of a file that isn't in the cache
+static int assembleUncached(char *baseFile, char *inputFile, char *outputFile) {
+    // Step 5: Run the pre-assembler
+    logMessage(LOG_INFO, LOG_DRIVER, "Running the pre-assembler on %s...\n", inputFile);
+    startPhase(PHASE_PRE);
+    int preAssembled = preAssembler(inputFile, context->keepExpandedFile ? outputFile : NULL);
+    endPhase(PHASE_PRE);
+    if (context->stats != NULL) {
+        context->stats->lines = context->counter;  // The pre-assembler counts every source line
+    }
+    if (preAssembled) {
+        logMessage(LOG_INFO, LOG_DRIVER, "Pre-assembler completed successfully for %s.\n", inputFile);
+    } else {
+        fprintf(context->output, "Pre-assembler found errors in %s, does not continue to first pass.\n", inputFile);
+        cleanupAssembler();
+        return 0;  // Move on to the next file if pre-assembler fails
+    }
 
-    // Step 1: Validate arguments
-    if (argc < 2) {
-        printf("Usage: %s <input_file_1> <input_file_2> ... <input_file_n>\n", argv[0]);
-        return 1;
+    // Steps 6-7: Run the first and second pass using the output of the pre-assembler
+    if (!runPasses(outputFile)) {
+        cleanupAssembler();
+        logMessage(LOG_INFO, LOG_DRIVER, "Moving to the next file\n");
+        return 0;  // Move on to the next file if one of the passes fails
     }
 
-    // Step 2: Loop through each base file name provided as argument
-    for (int i = 1; i < argc; i++) {
-        char *baseFile = argv[i];
-        char inputFile[MAX];    // To store the .asm file name
-        char outputFile[MAX];   // To store the .am file name
+    // Step 8: Conditionally create the entry and external files
+    startPhase(PHASE_OUTPUT);
+    if (hasEntrySymbols()) {
+        createEntryFile(baseFile);
+    }
 
-        // Step 3: Create the input file name by appending .asm to the base file name
-        snprintf(inputFile, sizeof(inputFile), "%s.asm", baseFile);
+    if (hasExternalReferences()) {
+        createExternalFile(baseFile);
+    }
 
-        // Check if the input file exists
-        FILE *file = fopen(inputFile, "r");
-        if (file == NULL) {
-            printf("Error: Input file '%s' does not exist or cannot be accessed.\n", inputFile);
-            continue;  // Move to the next file
-        }
+    // Step 9: Create the object files. The .ob is written last, since its presence
+    // in the cache marks a complete entry
+    if (context->binaryOutput) {
+        createBinaryObjectFile(baseFile);
+    }
+    storeDiagnostics();
+    createObjectFile(baseFile);
+    endPhase(PHASE_OUTPUT);
+
+    // Errors while writing the output files also fail the file
+    int succeeded = !context->foundError;
+    cleanupAssembler();
+    return succeeded;
+}
 
-        // Check if the file is empty
-        fseek(file, 0, SEEK_END);  // Move to the end of the file
-        if (ftell(file) == 0) {    // Check if the position is 0 (empty file)
-            printf("Error: Input file '%s' is empty.\n", inputFile);
-            fclose(file);
-            continue;  // Move to the next file
+// Runs the steps of assembling one file, see assembleFile
+static int assembleSteps(char *baseFile) {
+    char inputFile[MAX];    // To store the .asm file name
+    char outputFile[MAX];   // To store the .am file name
+    FILE *capture = NULL;
+
+    // Step 3: Create the input file name by appending .asm to the base file name
+    snprintf(inputFile, sizeof(inputFile), "%s.asm", baseFile);
+
+    // Missing and empty input files are reported by the pre-assembler when it opens them
+
+    // Step 4: Create the output file name by appending .am to the base file name.
+    // The expanded source stays in memory, the .am file is only written when requested
+    snprintf(outputFile, sizeof(outputFile), "%s.am", baseFile);
+
+    // A source that was assembled before with the same options is restored from the cache.
+    // With -k the pre-assembler has to run anyway to write the .am file
+    if (context->cacheDir != NULL && !context->keepExpandedFile) {
+        unsigned options = (unsigned)context->singlePassMode | ((unsigned)context->binaryOutput << 1);
+        if (!computeCacheKey(inputFile, options, context->cacheKey)) {
+            context->cacheDir = NULL;  // Missing input, the pre-assembler reports it
+        } else if (restoreFromCache(context->cacheDir, context->cacheKey, baseFile)) {
+            logMessage(LOG_INFO, LOG_DRIVER, "Restored the outputs of %s from the cache.\n", inputFile);
+            return 1;
+        } else {
+            // Capture the errors and warnings of the file for its cache entry, the -v
+            // messages still go straight to the output
+            capture = open_memstream(&context->diagnostics, &context->diagnosticsLength);
+            if (capture != NULL) {
+                context->output = capture;
+            }
         }
-        fclose(file);
+    }
 
-        // Step 4: Create the output file name by appending .am to the base file name
-        snprintf(outputFile, sizeof(outputFile), "%s.am", baseFile);
+    int succeeded = assembleUncached(baseFile, inputFile, outputFile);
 
-        // Step 5: Run the pre-assembler
-        printf("Running the pre-assembler on %s...\n", inputFile);
-        if (preAssembler(inputFile, outputFile)) {
-            printf("Pre-assembler completed successfully. Output written to: %s\n", outputFile);
-        } else {
-            printf("Pre-assembler found errors in %s, does not continue to first pass.\n", inputFile);
-            cleanupAssembler();
-            continue;  // Move on to the next file if pre-assembler fails
-        }
+    if (capture != NULL) {
+        context->output = context->logOutput;
+        fclose(capture);
+        fwrite(context->diagnostics, 1, context->diagnosticsLength, context->output);
+        free(context->diagnostics);
+        context->diagnostics = NULL;
+        context->diagnosticsLength = 0;
+    }
+    return succeeded;
+}
 
-        // Step 6: Run the first pass using the output of the pre-assembler
-        printf("Running the first pass on %s...\n", outputFile);
-        if (!firstPass(outputFile)) {
-            printf("First pass failed for %s.\n", outputFile);
-            cleanupAssembler();
-            printf("Moving to the next file\n");
-            continue;  // Move on to the next file if the first pass fails
-        }
+// Shared state of the worker pool
+static FileJob *jobs;              // The files, in command line order
+static FileJob **schedule;         // The same files, largest first
+static int numOfJobs;
+static int nextJob = 0;            // Index in schedule of the next file to start
+static int singlePassOption = 0;
+static int keepAmOption = 0;
+static int binaryOption = 0;
+static int statsFormatOption = 0;  // STATS_TABLE or STATS_JSON with --stats, 0 without
+static int memoryOption = 0;       // Adds the allocation counters to the statistics
+static const char *cacheDirOption = NULL;
+static int logLevelOption = LOG_ERROR;
+static unsigned logCategoriesOption = LOG_ALL;
+static pthread_mutex_t jobsLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t jobDone = PTHREAD_COND_INITIALIZER;
+
+// Assembles one file using the calling thread's context, timing it with --stats.
+// Returns 1 if the file was assembled without errors
+int assembleFile(char *baseFile) {
+    FileStats stats;
+
+    if (statsFormatOption != 0) {
+        memset(&stats, 0, sizeof(FileStats));
+        stats.phase = PHASE_TOTAL;
+        stats.trackAllocations = memoryOption;
+        context->stats = &stats;
+        chargeRetainedMemory(arenaRetainedBytes(context->arena), ALLOC_ARENA);  // Kept from the previous file
+    }
 
-        printf("First pass completed successfully for %s.\n", outputFile);
-        printInstructionList();
-        printDataList();
+    startPhase(PHASE_TOTAL);
+    int succeeded = assembleSteps(baseFile);
+    endPhase(PHASE_TOTAL);
 
-        // Step 7: Run the second pass
-        printf("Running the second pass on %s...\n", outputFile);
-        secondPass(outputFile);
+    if (context->stats != NULL) {
+        char inputFile[MAX];
+        snprintf(inputFile, sizeof(inputFile), "%s.asm", baseFile);
+        printFileStats(context->output, inputFile, succeeded, &stats, statsFormatOption);
+        context->stats = NULL;
+    }
+    return succeeded;
+}
 
-        if (foundError) {
-            printf("Second pass failed for %s.\n", outputFile);
-            cleanupAssembler();
-            continue;  // Move on to the next file if the second pass fails
-        }
+// Starts an empty context for a file, with the options of this run
+static void initFileContext(AssemblerContext *fileContext, FILE *output, Arena *arena) {
+    initAssemblerContext(fileContext, output, arena, singlePassOption, keepAmOption);
+    fileContext->binaryOutput = binaryOption;
+    fileContext->cacheDir = cacheDirOption;
+    fileContext->logLevel = logLevelOption;
+    fileContext->logCategories = logCategoriesOption;
+}
 
-        printf("Second pass completed successfully for %s.\n", outputFile);
-        printInstructionList();
-        printDataList();
+// Orders jobs by decreasing file size, so the longest files don't start last
+static int compareJobSize(const void *a, const void *b) {
+    const FileJob *jobA = *(FileJob * const *)a;
+    const FileJob *jobB = *(FileJob * const *)b;
 
-        // Step 8: Create the object file
-        createObjectFile(baseFile);
+    if (jobA->size != jobB->size) {
+        return (jobA->size < jobB->size) ? 1 : -1;
+    }
+    return (jobA < jobB) ? -1 : (jobA > jobB);  // Keep command line order between equal sizes
+}
 
-        // Step 9: Conditionally create the entry and external files
-        if (hasEntrySymbols()) {
-            createEntryFile(baseFile);
+// Worker thread: takes the next file from the schedule until none are left.
+// The messages of each file are collected in memory and printed by main, in order
+static void *assembleWorker(void *unused) {
+    AssemblerContext fileContext;
+    Arena arena;  // Reset after each file, so the worker's files reuse the same blocks
+    (void)unused;
+
+    initArena(&arena);
+    while (1) {
+        pthread_mutex_lock(&jobsLock);
+        FileJob *job = (nextJob < numOfJobs) ? schedule[nextJob++] : NULL;
+        pthread_mutex_unlock(&jobsLock);
+        if (job == NULL) {
+            break;
         }
 
-        if (hasExternalReferences()) {
-            createExternalFile(baseFile);
+        FILE *log = open_memstream(&job->log, &job->logSize);
+        if (log == NULL) {
+            printf("Memory allocation error!\n");
+            exit(1);
         }
-        cleanupAssembler();
-    }
 
-    printf("Assembler completed processing all files.\n");
-    return 0;
+        initFileContext(&fileContext, log, &arena);
+        context = &fileContext;
+        int succeeded = assembleFile(job->baseFile);
+        context = NULL;
+        fclose(log);
+
+        pthread_mutex_lock(&jobsLock);
+        job->succeeded = succeeded;
+        job->done = 1;
+        pthread_cond_broadcast(&jobDone);
+        pthread_mutex_unlock(&jobsLock);
+    }
+    freeArena(&arena);
+    return NULL;
 }
 
-// Check if there are any entry symbols in the symbol table
-int hasEntrySymbols() {
-    Symbol *current = symbolTable;  // Start with the head of the symbol table
+// Assembles the files on numOfThreads threads. Returns the number of files that failed
+static int assembleInParallel(char **baseFiles, int numOfFiles, int numOfThreads) {
+    pthread_t *threads;
+    int failed = 0;
+    int started = 0;
+
+    jobs = (FileJob *)calloc(numOfFiles, sizeof(FileJob));
+    schedule = (FileJob **)malloc(numOfFiles * sizeof(FileJob *));
+    threads = (pthread_t *)malloc(numOfThreads * sizeof(pthread_t));
+    if (jobs == NULL || schedule == NULL || threads == NULL) {
+        printf("Memory allocation error!\n");
+        exit(1);
+    }
+
+    // Schedule the largest files first, missing files are left to the pre-assembler to report
+    for (int i = 0; i < numOfFiles; i++) {
+        char inputFile[MAX];
+        struct stat info;
+
+        snprintf(inputFile, sizeof(inputFile), "%s.asm", baseFiles[i]);
+        jobs[i].baseFile = baseFiles[i];
+        jobs[i].size = (stat(inputFile, &info) == 0) ? (long)info.st_size : 0;
+        schedule[i] = &jobs[i];
+    }
+    qsort(schedule, numOfFiles, sizeof(FileJob *), compareJobSize);
+    numOfJobs = numOfFiles;
 
-    while (current != NULL) {
-        // Check if the symbol has the 'entry' property
-        if (strcmp(current->properties[2], "entry") == 0) {
-            return 1;  // Found an entry symbol
+    for (int i = 0; i < numOfThreads; i++) {
+        if (pthread_create(&threads[i], NULL, assembleWorker, NULL) != 0) {
+            printf("Error: Unable to start worker thread %d.\n", i + 1);
+            break;
         }
-        current = current->next;  // Move to the next symbol in the list
+        started++;
+    }
+    if (started == 0) {
+        assembleWorker(NULL);  // No worker could be started, assemble everything on this thread
     }
 
-    return 0;  // No entry symbols found
-}
+    // Print the messages of each file in command line order, as soon as the file is done
+    for (int i = 0; i < numOfFiles; i++) {
+        pthread_mutex_lock(&jobsLock);
+        while (!jobs[i].done) {
+            pthread_cond_wait(&jobDone, &jobsLock);
+        }
+        pthread_mutex_unlock(&jobsLock);
 
-// Check if there are any external references in the external references list
-int hasExternalReferences() {
-    ExternalReference *current = externalReferencesList;  // Start with the head of the external references list
+        fwrite(jobs[i].log, 1, jobs[i].logSize, stdout);
+        fflush(stdout);
+        free(jobs[i].log);
+        if (!jobs[i].succeeded) {
+            failed++;
+        }
+    }
 
-    // Traverse the external references list
-    while (current != NULL) {
-        return 1;  // As soon as we find an external reference, return 1
-        current = current->next;
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
     }
 
-    return 0;  // No external references found
+    free(threads);
+    free(schedule);
+    free(jobs);
+    return failed;
 }
 
-// Function to clean up the assembler's data structures
-void cleanupAssembler() {
-    // Free the symbol table
-    Symbol *currentSymbol = symbolTable;
-    while (currentSymbol != NULL) {
-        Symbol *temp = currentSymbol;
-        currentSymbol = currentSymbol->next;
-        free(temp);
-    }
-    symbolTable = NULL;
-
-    // Free the macro table
-    Macro *currentMacro = macroTable;
-    while (currentMacro != NULL) {
-        Macro *temp = currentMacro;
-        currentMacro = currentMacro->next;
-        free(temp);
+int main(int argc, char *argv[]) {
+    char **baseFiles;
+    int numOfFiles = 0;
+    int numOfThreads = 1;
+    int failed = 0;
+
+    baseFiles = (char **)malloc(argc * sizeof(char *));
+    if (baseFiles == NULL) {
+        printf("Memory allocation error!\n");
+        return 1;
     }
-    macroTable = NULL;
-
-    // Free the instruction list
-    InstructionNode *currentInstruction = instructionList;
-    while (currentInstruction != NULL) {
-        InstructionNode *temp = currentInstruction;
-        currentInstruction = currentInstruction->next;
-        free(temp);
+
+    // Step 1: Read the options and validate arguments
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "--single-pass") == 0) {
+            singlePassOption = 1;
+        } else if (strcmp(argv[i], "-k") == 0 || strcmp(argv[i], "--keep-am") == 0) {
+            keepAmOption = 1;
+        } else if (strcmp(argv[i], "-b") == 0 || strcmp(argv[i], "--binary") == 0) {
+            binaryOption = 1;
+        } else if (strcmp(argv[i], "--cache") == 0) {
+            if (i + 1 >= argc) {
+                printf("Error: '--cache' expects a directory.\n");
+                free(baseFiles);
+                return 1;
+            }
+            cacheDirOption = argv[++i];
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            statsFormatOption = STATS_TABLE;
+        } else if (strcmp(argv[i], "--memory") == 0) {
+            memoryOption = 1;
+            if (statsFormatOption == 0) {
+                statsFormatOption = STATS_TABLE;
+            }
+        } else if (strncmp(argv[i], "--stats=", 8) == 0) {
+            statsFormatOption = parseStatsFormat(argv[i] + 8);
+            if (statsFormatOption == 0) {
+                printf("Error: '--stats' expects table or json.\n");
+                free(baseFiles);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0) {
+            logLevelOption = LOG_INFO;
+        } else if (strcmp(argv[i], "-vv") == 0) {
+            logLevelOption = LOG_DEBUG;
+        } else if (strcmp(argv[i], "--log") == 0) {
+            logCategoriesOption = (i + 1 < argc) ? parseLogCategories(argv[i + 1]) : 0;
+            if (logCategoriesOption == 0) {
+                printf("Error: '--log' expects a list of driver, pre, first, second, tables, parse or all.\n");
+                free(baseFiles);
+                return 1;
+            }
+            i++;
+        } else if (strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--jobs") == 0) {
+            char *end = NULL;
+            long value = (i + 1 < argc) ? strtol(argv[i + 1], &end, 10) : 0;
+            if (end == NULL || end == argv[i + 1] || *end != '\0' || value < 1 || value > MAX_JOBS) {
+                printf("Error: '%s' expects a number of jobs between 1 and %d.\n", argv[i], MAX_JOBS);
+                free(baseFiles);
+                return 1;
+            }
+            numOfThreads = (int)value;
+            i++;
+        } else if (argv[i][0] == '-') {
+            printf("Error: Unknown option '%s'.\n", argv[i]);
+            free(baseFiles);
+            return 1;
+        } else {
+            baseFiles[numOfFiles++] = argv[i];
+        }
     }
-    instructionList = NULL;
-
-    // Free the data list
-    DataNode *currentData = dataList;
-    while (currentData != NULL) {
-        DataNode *temp = currentData;
-        currentData = currentData->next;
-        free(temp);
+
+    if (numOfFiles == 0) {
+        printf("Usage: %s [-s|--single-pass] [-k|--keep-am] [-b|--binary] [--cache DIR] [--stats[=table|json]] [--memory] [-j|--jobs N] [-v|-vv] [--log CATEGORIES] <input_file_1> <input_file_2> ... <input_file_n>\n", argv[0]);
+        free(baseFiles);
+        return 1;
     }
-    dataList = NULL;
-
-    // Free external references list
-    ExternalReference *currentExternalRef = externalReferencesList;
-    while (currentExternalRef != NULL) {
-        ExternalReference *temp = currentExternalRef;
-        currentExternalRef = currentExternalRef->next;
-        free(temp);
+
+    if (numOfThreads > numOfFiles) {
+        numOfThreads = numOfFiles;  // No use for more workers than files
     }
-    externalReferencesList = NULL;
 
-    // Reset error flag, data counter (DC), and instruction counter (IC)
-    foundError = 0;
-    DC = 0;
-    IC = 0;
-    counter = 0;
+    if (numOfThreads > 1) {
+        failed = assembleInParallel(baseFiles, numOfFiles, numOfThreads);
+    } else {
+        // Step 2: Loop through each base file name provided as argument
+        AssemblerContext fileContext;
+        Arena arena;
+        initArena(&arena);
+        for (int i = 0; i < numOfFiles; i++) {
+            initFileContext(&fileContext, stdout, &arena);
+            context = &fileContext;
+            if (!assembleFile(baseFiles[i])) {
+                failed++;
+            }
+            context = NULL;
+        }
+        freeArena(&arena);
+    }
 
-    // Any other cleanup if needed (e.g., resetting specific flags or state variables)
+    free(baseFiles);
+    if (logLevelOption >= LOG_INFO) {
+        printf("Assembler completed processing all files.\n");
+    }
+    if (failed > 0) {
+        printf("%d of %d files failed to assemble.\n", failed, numOfFiles);
+        return 1;
+    }
+    return 0;
 }
@@ -6,27 +6,29 @@
 #include "secondPass.h"
 #include "error.h"
 #include "globals.h"
+#include "assembler.h"
 
-// Function declarations for main.c
-
-// Function to check if any entry symbols exist in the symbol table
-int hasEntrySymbols();
+// Upper limit for the number of worker threads (-j)
+#define MAX_JOBS 256
 
-// Function to check if there are any external references in the external reference list
-int hasExternalReferences();
+// Function declarations for main.c
 
 // Function to create the output object file (.ob)
 void createObjectFile(char *baseFile);
 
+// Function to create the binary object file (.obj), with the entry and extern tables
+void createBinaryObjectFile(char *baseFile);
+
 // Function to create the entry file (.ent) if entry symbols exist
 void createEntryFile(char *baseFile);
 
 // Function to create the external reference file (.ext) if external references exist
 void createExternalFile(char *baseFile);
 
+// Function to assemble one file, using the current thread's context
+int assembleFile(char *baseFile);
+
 // Main function that manages the assembling process
 int main(int argc, char *argv[]);
 
-void cleanupAssembler();
-
 #endif // MAIN_H
@@ -0,0 +1,65 @@
+#ifndef OBJECTFILE_H
+#define OBJECTFILE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Binary object file (.obj), written with -b alongside the text .ob.
+ * It holds what the .ob, .ent and .ext files hold, laid out to be mapped and used in place.
+ * All integers are little-endian and every table starts on a 4-byte boundary:
+ *
+ *   BinaryObjectHeader                      32 bytes
+ *   words      (codeSize + dataSize) * 3    code then data words, 3 bytes each, padded to 4
+ *   entries    entryCount * ObjectSymbol    entry symbols and their values
+ *   externals  externalCount * ObjectSymbol external symbols and the addresses using them
+ *   names      namesSize bytes              null-terminated names, referenced by offset
+ *
+ * The CRC32C covers everything after the header.
+ */
+
+#define OBJECT_MAGIC "EOBJ"
+#define OBJECT_VERSION 1
+#define OBJECT_WORD_SIZE 3
+
+// Header flags
+#define OBJECT_HAS_ENTRIES 1u    // The entry table is not empty
+#define OBJECT_HAS_EXTERNALS 2u  // The extern table is not empty
+
+typedef struct BinaryObjectHeader {
+    char magic[4];           // OBJECT_MAGIC
+    uint16_t version;        // OBJECT_VERSION
+    uint16_t flags;          // OBJECT_HAS_* flags
+    uint32_t codeSize;       // Number of code words (ICF - 100), the first is at address 100
+    uint32_t dataSize;       // Number of data words (IDF), following the code
+    uint32_t entryCount;     // Number of entry table records
+    uint32_t externalCount;  // Number of extern table records
+    uint32_t namesSize;      // Size of the name pool in bytes
+    uint32_t crc;            // CRC32C of everything after the header
+} BinaryObjectHeader;
+
+// A record of the entry or extern table
+typedef struct ObjectSymbol {
+    uint32_t nameOffset;  // Offset of the name in the name pool
+    uint32_t address;     // Value of an entry symbol, or address of a word using an external symbol
+} ObjectSymbol;
+
+// Offsets of the sections from the start of the file
+#define OBJECT_WORDS_OFFSET ((size_t)sizeof(BinaryObjectHeader))
+#define OBJECT_ENTRIES_OFFSET(header) \
+    (OBJECT_WORDS_OFFSET + (((size_t)((header)->codeSize + (header)->dataSize) * OBJECT_WORD_SIZE + 3) & ~(size_t)3))
+#define OBJECT_EXTERNALS_OFFSET(header) \
+    (OBJECT_ENTRIES_OFFSET(header) + (size_t)(header)->entryCount * sizeof(ObjectSymbol))
+#define OBJECT_NAMES_OFFSET(header) \
+    (OBJECT_EXTERNALS_OFFSET(header) + (size_t)(header)->externalCount * sizeof(ObjectSymbol))
+#define OBJECT_FILE_SIZE(header) (OBJECT_NAMES_OFFSET(header) + (header)->namesSize)
+
+uint32_t crc32c(uint32_t crc, const unsigned char *data, size_t length);
+void writeBinaryObject(FILE *stream);
+int checkBinaryObject(const unsigned char *data, size_t length);
+uint32_t objectWord(const unsigned char *data, uint32_t index);
+void readObjectHeader(const unsigned char *data, BinaryObjectHeader *header);
+void readObjectSymbol(const unsigned char *data, size_t offset, uint32_t index, ObjectSymbol *symbol);
+
+#endif
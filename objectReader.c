@@ -0,0 +1,254 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include "objectReader.h"
+#include "dataStructures.h"
+#include "sourceReader.h"
+#include "objectFile.h"
+
+// Parses a decimal or hexadecimal number at *text, moving *text past it. Returns 0 if there is none.
+// A number too large for a long reads as LONG_MAX
+int parseNumber(const char **text, const char *end, int base, long *value) {
+    long result = 0;
+    const char *p = *text;
+    int digits = 0;
+
+    while (p < end && isspace((unsigned char)*p)) {
+        p++;
+    }
+    for (; p < end && isxdigit((unsigned char)*p); p++, digits++) {
+        int digit = isdigit((unsigned char)*p) ? *p - '0' : tolower((unsigned char)*p) - 'a' + 10;
+        if (digit >= base) {
+            break;
+        }
+        result = (result > (LONG_MAX - digit) / base) ? LONG_MAX : result * base + digit;
+    }
+    *text = p;
+    *value = result;
+    return digits > 0;
+}
+
+/**
+ * @brief Reads an .ob file: the counts line, then an address and a hex word per line.
+ *
+ * @param words Set to a malloc'd array of the code words followed by the data words.
+ * @return int 1 on success, 0 if the file can't be read or is malformed.
+ */
+int readObjectFile(const char *fileName, Word **words, int *codeSize, int *dataSize) {
+    SourceFile file;
+    LineView view;
+    size_t offset = 0;
+    long codeCount, dataCount;
+    const char *p;
+
+    *words = NULL;
+    *codeSize = *dataSize = 0;
+    if (!openSourceFile(fileName, &file)) {
+        printf("Error: Unable to open object file: %s\n", fileName);
+        return 0;
+    }
+
+    if (!nextLineView(&file, &offset, &view) ||
+        (p = view.start, !parseNumber(&p, view.start + view.length, 10, &codeCount)) ||
+        !parseNumber(&p, view.start + view.length, 10, &dataCount)) {
+        printf("Error: Missing the counts line in %s\n", fileName);
+        closeSourceFile(&file);
+        return 0;
+    }
+
+    // The counts are checked before anything is allocated for them, a corrupt header
+    // is reported like any other malformed object
+    if (codeCount > MAX_OBJECT_WORDS || dataCount > MAX_OBJECT_WORDS ||
+        codeCount + dataCount > MAX_OBJECT_WORDS ||
+        (size_t)(codeCount + dataCount) > file.length / MIN_WORD_LINE_LENGTH) {
+        printf("Error: Bad counts line in %s: %ld code and %ld data words\n", fileName, codeCount, dataCount);
+        closeSourceFile(&file);
+        return 0;
+    }
+
+    int total = (int)(codeCount + dataCount);
+    *codeSize = (int)codeCount;
+    *dataSize = (int)dataCount;
+    *words = (Word *)calloc(total + 1, sizeof(Word));
+    if (*words == NULL) {
+        printf("Memory allocation error!\n");
+        exit(1);
+    }
+
+    int count = 0;
+    while (nextLineView(&file, &offset, &view)) {
+        const char *end = view.start + view.length;
+        long address, word;
+
+        p = view.start;
+        if (!parseNumber(&p, end, 10, &address)) {
+            continue;  // Empty line
+        }
+        if (!parseNumber(&p, end, 16, &word) || address != CODE_START_ADDRESS + count || count >= total) {
+            printf("Error: Malformed word at address %ld in %s\n", address, fileName);
+            closeSourceFile(&file);
+            return 0;
+        }
+        (*words)[count++] = (Word)word & WORD_MASK;
+    }
+    closeSourceFile(&file);
+
+    if (count != total) {
+        printf("Error: %s holds %d words, its counts line says %d\n", fileName, count, total);
+        return 0;
+    }
+    return 1;
+}
+
+// Copies a table of a binary object into symbols, as if its records were the lines of an .ent or .ext file
+static void readObjectTable(const unsigned char *data, const BinaryObjectHeader *header, size_t offset,
+                            uint32_t count, SymbolFile *symbols) {
+    ObjectSymbol record;
+
+    memset(symbols, 0, sizeof(SymbolFile));
+    symbols->text = (char *)malloc(header->namesSize + 1);
+    symbols->lines = (SymbolLine *)malloc((count + 1) * sizeof(SymbolLine));
+    if (symbols->text == NULL || symbols->lines == NULL) {
+        printf("Memory allocation error!\n");
+        exit(1);
+    }
+    memcpy(symbols->text, data + OBJECT_NAMES_OFFSET(header), header->namesSize);
+    symbols->text[header->namesSize] = '\0';
+
+    for (uint32_t i = 0; i < count; i++) {
+        readObjectSymbol(data, offset, i, &record);
+        symbols->lines[i].name = symbols->text + record.nameOffset;
+        symbols->lines[i].address = (record.address > INT_MAX) ? INT_MAX : (int)record.address;
+    }
+    symbols->count = (int)count;
+}
+
+/**
+ * @brief Reads a binary object file (.obj): the words, and the entry and extern tables
+ * in place of the .ent and .ext files.
+ *
+ * The file is mapped and checked with checkBinaryObject, then read in place.
+ *
+ * @param words Set to a malloc'd array of the code words followed by the data words.
+ * @return int 1 on success, 0 if the file can't be read or is not a valid binary object.
+ */
+int readBinaryObjectFile(const char *fileName, Word **words, int *codeSize, int *dataSize,
+                         SymbolFile *entries, SymbolFile *externals) {
+    SourceFile file;
+    BinaryObjectHeader header;
+
+    *words = NULL;
+    *codeSize = *dataSize = 0;
+    memset(entries, 0, sizeof(SymbolFile));
+    memset(externals, 0, sizeof(SymbolFile));
+    if (!openSourceFile(fileName, &file)) {
+        printf("Error: Unable to open object file: %s\n", fileName);
+        return 0;
+    }
+
+    const unsigned char *data = (const unsigned char *)file.text;
+    if (!checkBinaryObject(data, file.length)) {
+        printf("Error: %s is not a valid binary object file\n", fileName);
+        closeSourceFile(&file);
+        return 0;
+    }
+    readObjectHeader(data, &header);
+    if ((uint64_t)header.codeSize + header.dataSize > MAX_OBJECT_WORDS || header.entryCount > INT_MAX ||
+        header.externalCount > INT_MAX) {
+        printf("Error: Bad counts in %s: %lu code and %lu data words\n", fileName,
+               (unsigned long)header.codeSize, (unsigned long)header.dataSize);
+        closeSourceFile(&file);
+        return 0;
+    }
+
+    int total = (int)(header.codeSize + header.dataSize);
+    *codeSize = (int)header.codeSize;
+    *dataSize = (int)header.dataSize;
+    *words = (Word *)malloc((total + 1) * sizeof(Word));
+    if (*words == NULL) {
+        printf("Memory allocation error!\n");
+        exit(1);
+    }
+    for (int i = 0; i < total; i++) {
+        (*words)[i] = (Word)objectWord(data, (uint32_t)i);
+    }
+
+    readObjectTable(data, &header, OBJECT_ENTRIES_OFFSET(&header), header.entryCount, entries);
+    readObjectTable(data, &header, OBJECT_EXTERNALS_OFFSET(&header), header.externalCount, externals);
+    closeSourceFile(&file);
+    return 1;
+}
+
+// Parses the "name address" lines of .ent or .ext content held in memory into symbols
+void parseSymbolText(const char *text, size_t length, SymbolFile *symbols) {
+    SourceFile file = {(char *)text, length, 0, 0};
+    LineView view;
+    size_t offset = 0;
+    int capacity = 0;
+
+    memset(symbols, 0, sizeof(SymbolFile));
+    symbols->text = (char *)malloc(length + 1);
+    if (symbols->text == NULL) {
+        printf("Memory allocation error!\n");
+        exit(1);
+    }
+    memcpy(symbols->text, text, length);
+    symbols->text[length] = '\0';
+
+    while (nextLineView(&file, &offset, &view)) {
+        char *start = symbols->text + (view.start - file.text);
+        const char *end = start + view.length;
+        char *nameEnd = start;
+        long address;
+
+        while (nameEnd < end && !isspace((unsigned char)*nameEnd)) {
+            nameEnd++;
+        }
+        const char *p = nameEnd;
+        if (nameEnd == start || !parseNumber(&p, end, 10, &address)) {
+            continue;  // Empty or malformed line
+        }
+        *nameEnd = '\0';
+
+        if (symbols->count == capacity) {
+            capacity = (capacity > 0) ? capacity * 2 : 64;
+            SymbolLine *lines = (SymbolLine *)realloc(symbols->lines, capacity * sizeof(SymbolLine));
+            if (lines == NULL) {
+                printf("Memory allocation error!\n");
+                exit(1);
+            }
+            symbols->lines = lines;
+        }
+        symbols->lines[symbols->count].name = start;
+        symbols->lines[symbols->count].address = (int)address;
+        symbols->count++;
+    }
+}
+
+/**
+ * @brief Reads the "name address" lines of an .ent or .ext file.
+ *
+ * A missing file reads as an empty one, since the assembler only writes
+ * these files when there are symbols.
+ *
+ * @return int 1 if the file was read, 0 if it doesn't exist (symbols is left empty).
+ */
+int readSymbolFile(const char *fileName, SymbolFile *symbols) {
+    SourceFile file;
+
+    memset(symbols, 0, sizeof(SymbolFile));
+    if (!openSourceFile(fileName, &file)) {
+        return 0;
+    }
+    parseSymbolText(file.text, file.length, symbols);
+    closeSourceFile(&file);
+    return 1;
+}
+
+void freeSymbolFile(SymbolFile *symbols) {
+    free(symbols->text);
+    free(symbols->lines);
+    memset(symbols, 0, sizeof(SymbolFile));
+}
@@ -0,0 +1,33 @@
+#ifndef OBJECTREADER_H
+#define OBJECTREADER_H
+
+#include <stddef.h>
+#include "bitUtils.h"
+
+// Limits of the counts line of an .ob file. Addresses are written with 7 digits, and a
+// word line is at least 6 bytes ("100 0" and the newline)
+#define MAX_OBJECT_WORDS (9999999 - 100 + 1)
+#define MIN_WORD_LINE_LENGTH 6
+
+// A line of an .ent or .ext file
+typedef struct SymbolLine {
+    const char *name;  // Symbol name, points into the file's text
+    int address;       // Value of the entry, or address of the word using the external
+} SymbolLine;
+
+// The lines of an .ent or .ext file
+typedef struct SymbolFile {
+    char *text;         // Copy of the file with each name null-terminated
+    SymbolLine *lines;  // The lines, in file order
+    int count;
+} SymbolFile;
+
+int parseNumber(const char **text, const char *end, int base, long *value);
+int readObjectFile(const char *fileName, Word **words, int *codeSize, int *dataSize);
+void parseSymbolText(const char *text, size_t length, SymbolFile *symbols);
+int readSymbolFile(const char *fileName, SymbolFile *symbols);
+int readBinaryObjectFile(const char *fileName, Word **words, int *codeSize, int *dataSize,
+                         SymbolFile *entries, SymbolFile *externals);
+void freeSymbolFile(SymbolFile *symbols);
+
+#endif
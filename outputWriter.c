@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <string.h>
+#include "outputWriter.h"
+
+// Two characters per entry: the hex digits of every byte value and the decimal digits of 0-99
+static const char hexPairs[] =
+    "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"
+    "202122232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f"
+    "404142434445464748494a4b4c4d4e4f505152535455565758595a5b5c5d5e5f"
+    "606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f"
+    "808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f"
+    "a0a1a2a3a4a5a6a7a8a9aaabacadaeafb0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+    "c0c1c2c3c4c5c6c7c8c9cacbcccdcecfd0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+    "e0e1e2e3e4e5e6e7e8e9eaebecedeeeff0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+static const char decimalPairs[] =
+    "0001020304050607080910111213141516171819202122232425262728293031"
+    "3233343536373839404142434445464748495051525354555657585960616263"
+    "6465666768697071727374757677787980818283848586878889909192939495"
+    "96979899";
+
+void initOutputBuffer(OutputBuffer *buffer, FILE *stream) {
+    buffer->stream = stream;
+    buffer->length = 0;
+}
+
+// Writes the buffered bytes to the stream and empties the buffer
+void flushOutputBuffer(OutputBuffer *buffer) {
+    if (buffer->length > 0) {
+        fwrite(buffer->data, 1, buffer->length, buffer->stream);
+        buffer->length = 0;
+    }
+}
+
+// Makes sure the buffer has room for 'required' more bytes
+static void reserve(OutputBuffer *buffer, size_t required) {
+    if (buffer->length + required > OUTPUT_BUFFER_SIZE) {
+        flushOutputBuffer(buffer);
+    }
+}
+
+void appendText(OutputBuffer *buffer, const char *text, size_t length) {
+    if (length > OUTPUT_BUFFER_SIZE) {
+        flushOutputBuffer(buffer);
+        fwrite(text, 1, length, buffer->stream);  // Too long to buffer, write it directly
+        return;
+    }
+    reserve(buffer, length);
+    memcpy(buffer->data + buffer->length, text, length);
+    buffer->length += length;
+}
+
+// Formats a value as 7 decimal digits with leading zeros, like "%07d".
+// Returns the number of characters written, values that don't fit in 7 digits fall back to snprintf
+static size_t formatAddress(char *out, int value) {
+    if (value < 0 || value > 9999999) {
+        char text[16];
+        int length = snprintf(text, sizeof(text), "%07d", value);
+        memcpy(out, text, (size_t)length);
+        return (size_t)length;
+    }
+    out[0] = (char)('0' + value / 1000000);
+    memcpy(out + 1, decimalPairs + 2 * ((value / 10000) % 100), 2);
+    memcpy(out + 3, decimalPairs + 2 * ((value / 100) % 100), 2);
+    memcpy(out + 5, decimalPairs + 2 * (value % 100), 2);
+    return 7;
+}
+
+// Appends an object file line: the address, then the word as six hex digits, like "%07d %06x\n"
+void appendObjectLine(OutputBuffer *buffer, int address, Word word) {
+    reserve(buffer, 32);
+    char *out = buffer->data + buffer->length;
+    size_t length = formatAddress(out, address);
+
+    out[length] = ' ';
+    memcpy(out + length + 1, hexPairs + 2 * ((word >> 16) & 0xFF), 2);
+    memcpy(out + length + 3, hexPairs + 2 * ((word >> 8) & 0xFF), 2);
+    memcpy(out + length + 5, hexPairs + 2 * (word & 0xFF), 2);
+    out[length + 7] = '\n';
+    buffer->length += length + 8;
+}
+
+// Appends an entry or external file line: the symbol name, then the address, like "%s %07d\n"
+void appendSymbolLine(OutputBuffer *buffer, const char *name, int address) {
+    appendText(buffer, name, strlen(name));
+    reserve(buffer, 32);
+    char *out = buffer->data + buffer->length;
+    out[0] = ' ';
+    size_t length = formatAddress(out + 1, address);
+    out[length + 1] = '\n';
+    buffer->length += length + 2;
+}
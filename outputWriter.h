@@ -0,0 +1,23 @@
+#ifndef OUTPUTWRITER_H
+#define OUTPUTWRITER_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "bitUtils.h"
+
+#define OUTPUT_BUFFER_SIZE 32768  // Bytes collected before each write
+
+// Output formatted into one large buffer and written to the stream in a few large writes
+typedef struct OutputBuffer {
+    FILE *stream;                    // Where the buffer is written when it fills up
+    size_t length;                   // Number of bytes used
+    char data[OUTPUT_BUFFER_SIZE];
+} OutputBuffer;
+
+void initOutputBuffer(OutputBuffer *buffer, FILE *stream);
+void appendText(OutputBuffer *buffer, const char *text, size_t length);
+void appendObjectLine(OutputBuffer *buffer, int address, Word word);
+void appendSymbolLine(OutputBuffer *buffer, const char *name, int address);
+void flushOutputBuffer(OutputBuffer *buffer);
+
+#endif
@@ -5,21 +5,7 @@
 #include "preAssembler.h"
 #include "globals.h"
 #include "errors.h"
-
-/* Function to ignore empty lines or lines with only spaces */
-int ignorePre(char *line) {
-    int i, length;
-    
-    /* Store the length once to avoid repeated calls to strlen */
-    length = (int)strlen(line);
-
-    for (i = 0; i < length; i++) {
-        if (!isspace((unsigned char)line[i])) {
-            return 0;  /* Not a whitespace-only line */
-        }
-    }
-    return 1;  /* Skip whitespace-only lines */
-}
+#include "sourceReader.h"
 
 // Function to check if a macro name is valid (starts with a letter, can include alphanumeric and underscores)
 int isValidMacroName(char *macroName) {
@@ -54,12 +40,8 @@ int isReservedOrDeclared(char *macroName) {
     }
 
     // Step 3: Check if the name is already declared as a macro
-    Macro *current = macroTable;
-    while (current != NULL) {
-        if (strcmp(current->name, macroName) == 0) {
-            return 1;  // Macro name is already declared
-        }
-        current = current->next;
+    if (findMacro(macroName) != NULL) {
+        return 1;  // Macro name is already declared
     }
 
     return 0;  // Name is neither reserved nor declared
@@ -82,28 +64,28 @@ int isMacroInitialization(char line[]) {
 
     // Step 3: Check if there are any characters before "mcro"
     if (mcroPosition != line) {
-        raiseError("Error: Characters found before 'mcro' at the beginning of the macro definition in line %d.\n", counter);
+        raiseError("Error: Characters found before 'mcro' at the beginning of the macro definition in line %d.\n", context->counter);
         return 0;
     }
 
     // Step 4: Check if "mcro" is followed directly by a macro name without space (e.g., "mcroMacroName")
     if (line[4] != ' ') {  // There must be a space immediately after "mcro"
-        raiseError("Error: 'mcro' and the macro name cannot be connected in line %d. Use a space after 'mcro'.\n", counter);
+        raiseError("Error: 'mcro' and the macro name cannot be connected in line %d. Use a space after 'mcro'.\n", context->counter);
         return 0;
     }
 
-    // Step 5: Extract the macro keyword and name
-    int scannedFields = sscanf(line, "mcro %s", macroName);
+    // Step 5: Extract the macro keyword and name (longer names are reported as extra characters)
+    int scannedFields = sscanf(line, "mcro %79s", macroName);
 
     // Step 6: Check if we correctly extracted the macro name
     if (scannedFields != 1) {
-        raiseError("Error: Macro name is missing or invalid in line: %d\n", counter);
+        raiseError("Error: Macro name is missing or invalid in line: %d\n", context->counter);
         return 0;
     }
 
     // Step 7: Validate the macro name (starts with a letter, contains alphanumeric or underscores)
     if (!isValidMacroName(macroName)) {
-        raiseError("Error: Macro name '%s' in line %d is invalid. Must start with a letter and contain only alphanumeric characters or underscores.\n", macroName, counter);
+        raiseError("Error: Macro name '%s' in line %d is invalid. Must start with a letter and contain only alphanumeric characters or underscores.\n", macroName, context->counter);
         return 0;
     }
 
@@ -127,7 +109,7 @@ int isMacroInitialization(char line[]) {
     }
 
     // If everything is valid
-    printf("Valid macro initialization: mcro %s\n", macroName); // Debug line
+    logMessage(LOG_DEBUG, LOG_PRE, "Valid macro initialization: mcro %s\n", macroName); // Debug line
     return 1;
 }
 
@@ -141,7 +123,7 @@ int isEndMacro(char *line) {
 
     // Step 2: Check if there are characters before "mcroend"
     if (endMacroPosition != line) {
-        raiseError("Error: Characters found before 'mcroend' in line %d.\n", counter);
+        raiseError("Error: Characters found before 'mcroend' in line %d.\n", context->counter);
         return 0;
     }
 
@@ -155,7 +137,7 @@ int isEndMacro(char *line) {
 
     // Step 4: Check if there are any characters after "mcroend"
     if (*remaining != '\0' && *remaining != '\n') {
-        raiseError("Error: Extra characters found after 'mcroend' in line %d.\n", counter);
+        raiseError("Error: Extra characters found after 'mcroend' in line %d.\n", context->counter);
         return 0;
     }
 
@@ -164,239 +146,294 @@ int isEndMacro(char *line) {
 }
 
 /**
- * @brief Adds a macro to the macro table (linked list).
+ * @brief Returns the hash slot holding a macro name, or the empty slot where it would go.
+ * 
+ * @param name The macro name to search for.
+ * @return Macro** Pointer to the slot in the macro index.
+ */
+static Macro **findMacroSlot(const char *name) {
+    unsigned long mask;
+    unsigned long i;
+
+    mask = (unsigned long)context->macroIndex.capacity - 1;
+    i = hashName(name) & mask;
+    while (context->macroIndex.slots[i] != NULL && strcmp(context->macroIndex.slots[i]->name, name) != 0) {
+        i = (i + 1) & mask;  /* Linear probing */
+    }
+    return &context->macroIndex.slots[i];
+}
+
+/**
+ * @brief Doubles the macro hash index (or creates it), keeping the load factor at most 1/2.
+ */
+static void growMacroIndex() {
+    Macro **oldSlots;
+    int oldCapacity;
+    int i;
+
+    oldSlots = context->macroIndex.slots;
+    oldCapacity = context->macroIndex.capacity;
+    context->macroIndex.capacity = (oldCapacity > 0) ? oldCapacity * 2 : 32;
+    context->macroIndex.slots = (Macro **)trackedAlloc(context->macroIndex.capacity * sizeof(Macro *), ALLOC_MACROS);
+    memset(context->macroIndex.slots, 0, context->macroIndex.capacity * sizeof(Macro *));
+
+    /* Re-insert the existing macros */
+    for (i = 0; i < oldCapacity; i++) {
+        if (oldSlots[i] != NULL) {
+            *findMacroSlot(oldSlots[i]->name) = oldSlots[i];
+        }
+    }
+    trackedFree(oldSlots, oldCapacity * sizeof(Macro *), ALLOC_MACROS);
+}
+
+/**
+ * @brief Finds a macro by name.
+ * 
+ * @param name The macro name to search for.
+ * @return Macro* Pointer to the macro, or NULL if no macro has this name.
+ */
+Macro *findMacro(const char *name) {
+    if (context->macroIndex.count == 0) {
+        return NULL;
+    }
+    return *findMacroSlot(name);
+}
+
+/**
+ * @brief Adds a macro to the macro table (hash index and definition-order list).
  * 
- * @param head Pointer to the head of the macro linked list.
  * @param name Pointer to the macro name string.
  * @param content Pointer to the macro content string.
- * @return Macro* Returns a pointer to the updated macro table.
+ * @return Macro* Returns a pointer to the new macro, or NULL if it couldn't be added.
  */
-Macro *addToMacroTable(Macro *head, char *name, char *content) {
+Macro *addToMacroTable(char *name, char *content) {
     Macro *newMacro;
-    Macro *current;
+    Macro **slot;
 
-    /* Allocate memory for the new macro */
-    newMacro = (Macro *)malloc(sizeof(Macro));
-    if (newMacro == NULL) {
-        printf("Error allocating memory for new macro.\n");
-        return head;
+    if (2 * (context->macroIndex.count + 1) > context->macroIndex.capacity) {
+        growMacroIndex();
+    }
+
+    /* A name that is already taken is not redefined */
+    slot = findMacroSlot(name);
+    if (*slot != NULL) {
+        fprintf(context->output, "Error: Macro '%s' is already defined.\n", name);
+        return NULL;
     }
 
+    /* Allocate memory for the new macro */
+    newMacro = (Macro *)arenaAlloc(context->arena, sizeof(Macro), ALLOC_MACROS);
+
     /* Copy macro name and content */
     strcpy(newMacro->name, name);
     strcpy(newMacro->content, content);
     newMacro->next = NULL;
 
-    /* If the list is empty, return the new macro as the head */
-    if (head == NULL) {
-        return newMacro;
+    /* Append the new macro at the end of the list, in definition order */
+    if (context->macroTable == NULL) {
+        context->macroTable = newMacro;
+    } else {
+        context->macroIndex.tail->next = newMacro;
     }
+    context->macroIndex.tail = newMacro;
 
-    /* Traverse to the last macro in the list */
-    current = head;
-    while (current->next != NULL) {
-        current = current->next;
-    }
+    /* Index the new macro by name */
+    *slot = newMacro;
+    context->macroIndex.count++;
 
-    /* Append the new macro at the end */
-    current->next = newMacro;
-
-    return head;
+    return newMacro;
 }
 
 /**
  * @brief Parses and stores a macro name from a line.
  * 
- * @param head Pointer to the head of the macro linked list.
  * @param line Pointer to the input line containing the macro definition.
- * @return Macro* Returns a pointer to the updated macro table.
+ * @return Macro* Returns a pointer to the new macro.
  */
-Macro *insertMacroName(Macro *head, char *line) {
+Macro *insertMacroName(char *line) {
     char name[MAX];
 
     /* Extract the macro name from the line (skip "mcro" keyword) */
-    sscanf(line, "%*s %s", name);
+    sscanf(line, "%*s %79s", name);
 
     /* Add the macro to the macro table with an empty content field */
-    return addToMacroTable(head, name, "");
+    return addToMacroTable(name, "");
 }
 
 /**
- * @brief Appends content to the last macro in the linked list.
+ * @brief Appends content to the macro being defined.
  * 
- * @param head Pointer to the head of the macro linked list.
+ * @param macro Pointer to the macro being defined.
  * @param line Pointer to the content line to be added.
  */
-void insertMacroContent(Macro *head, char *line) {
-    Macro *current;
+void insertMacroContent(Macro *macro, char *line) {
     size_t len;
 
-    current = head; /* Declare at the top, per ISO C90 */
-
-    /* Traverse to the last macro in the list */
-    while (current->next != NULL) {
-        current = current->next;
+    /* The content buffer is fixed size, reject lines that don't fit */
+    if (strlen(macro->content) + strlen(line) + 2 > sizeof(macro->content)) {
+        raiseError("Error: Macro '%s' is too long in line %d.\n", macro->name, context->counter);
+        return;
     }
 
     /* Append the new content */
-    strcat(current->content, line);
+    strcat(macro->content, line);
 
     /* Ensure exactly one newline at the end */
-    len = strlen(current->content);
-    while (len > 0 && current->content[len - 1] == '\n') {
-        current->content[--len] = '\0';
-    }
-    strcat(current->content, "\n");
-}
-
-/**
- * @brief Checks if the given name matches any macro name in the linked list.
- * 
- * @param head Pointer to the head of the macro linked list.
- * @param name The macro name to search for.
- * @return int Returns 1 if the macro name exists, 0 otherwise.
- */
-int isMacroName(Macro *head, char *name) {
-    Macro *current;
-    current = head; 
-
-    while (current != NULL) {
-        if (strcmp(current->name, name) == 0) {
-            return 1;
-        }
-        current = current->next;
-    }
-    return 0;
-}
-
-/**
- * @brief Removes trailing newline characters from a string.
- * 
- * @param str Pointer to the string to be trimmed.
- */
-void trimTrailingNewline(char *str) {
-    int len;
-    
-    len = strlen(str);
-    while (len > 0 && str[len - 1] == '\n') {
-        str[--len] = '\0';
+    len = strlen(macro->content);
+    while (len > 0 && macro->content[len - 1] == '\n') {
+        macro->content[--len] = '\0';
     }
+    strcat(macro->content, "\n");
 }
 
-/**
- * @brief Replaces a macro name with its corresponding content.
- * 
- * @param head Pointer to the head of the macro linked list.
- * @param macroName Pointer to the macro name to search for.
- * @param replacedLine Pointer to the buffer where the macro content will be copied.
- */
-void replaceMacro(Macro *head, char *macroName, char *replacedLine) {
-    Macro *current;
-
-    current = head; /* Declare at the top, per ISO C90 */
-
-    while (current != NULL) {
-        if (strcmp(current->name, macroName) == 0) {
-            strcpy(replacedLine, current->content);  /* Replace with the macro content */
-            
-            /* Use a helper function to trim newlines */
-            trimTrailingNewline(replacedLine);
-            
-            return;
-        }
-        current = current->next;
-    }
-}
-
-// Main function to process the file, replacing macros with their content
-void processFile(char *inputFile, char *outputFile, Macro *head) {
-    FILE *fpInput = fopen(inputFile, "r");
-    FILE *fpOutput = fopen(outputFile, "w");
-    char line[MAX];
+// Replaces the macros of a source held in memory with their content.
+// Each line is appended to the output once and checked in place, lines that
+// turn out to be macro definitions or invocations are taken back out
+void expandSource(const SourceFile *source, SourceBuffer *output) {
+    LineView view;
+    size_t offset = 0;
     int isMacro = 0;
+    Macro *currentMacro = NULL;  // The macro being defined
 
-    if (fpInput == NULL) {
-        printf("Error: Unable to open file %s\n", inputFile);
-        return;
-    }
-
-    if (fpOutput == NULL) {
-        printf("Error: Unable to create file %s\n", outputFile);
-        fclose(fpInput);
-        return;
-    }
-
-    while (fgets(line, MAX, fpInput)) {
-        line[strcspn(line, "\n")] = '\0';  // Remove newline character
-        counter++;
+    while (nextLineView(source, &offset, &view)) {
+        context->counter++;
 
         // Remove leading whitespaces from all lines
-        char *trimmedLine = line;
-        while (isspace(*trimmedLine)) {
-            trimmedLine++;
+        const char *start = view.start;
+        const char *end = view.start + view.length;
+        while (start < end && isspace((unsigned char)*start)) {
+            start++;
         }
 
-        if (ignorePre(trimmedLine)) {
+        if (start == end) {
             continue;  // Skip empty lines
         }
 
+        size_t mark = output->length;
+        char *trimmedLine = appendSourceLine(output, start, (size_t)(end - start));
+
         if (isMacro) {  // Inside a macro definition
             if (isEndMacro(trimmedLine)) {
                 isMacro = 0;  // End macro definition
-                continue;
-            } else {
-                insertMacroContent(head, trimmedLine);
-                continue;
+            } else if (currentMacro != NULL) {
+                insertMacroContent(currentMacro, trimmedLine);
             }
+            output->length = mark;  // Macro definitions aren't part of the output
+            continue;
         }
 
         if (isMacroInitialization(trimmedLine)) {  // Start of a new macro
-            head = insertMacroName(head, trimmedLine);
+            currentMacro = insertMacroName(trimmedLine);
             isMacro = 1;
+            output->length = mark;
             continue;
         }
 
-        char replacedLine[MAX] = "";
-        if (isMacroName(head, trimmedLine)) {
-            replaceMacro(head, trimmedLine, replacedLine);
-            fprintf(fpOutput, "%s\n", replacedLine);  // Write macro content without extra newlines
-        } else {
-            fprintf(fpOutput, "%s\n", trimmedLine);  // Write regular line without extra newlines
+        // One hash probe decides whether the line is a macro invocation
+        Macro *invokedMacro = findMacro(trimmedLine);
+        if (invokedMacro != NULL) {
+            context->macroIndex.expansions++;
+            size_t contentLength = strlen(invokedMacro->content);
+            while (contentLength > 0 && invokedMacro->content[contentLength - 1] == '\n') {
+                contentLength--;  // Append macro content without extra newlines
+            }
+            output->length = mark;
+            appendSourceLine(output, invokedMacro->content, contentLength);
         }
     }
+}
 
-    fclose(fpInput);
-    fclose(fpOutput);
+// Main function to process the file, replacing macros with their content
+int processFile(char *inputFile, SourceBuffer *output) {
+    SourceFile source;
+
+    if (!openSourceFile(inputFile, &source)) {
+        fprintf(context->output, "Error: Input file '%s' does not exist or cannot be accessed.\n", inputFile);
+        return 0;
+    }
+
+    if (source.length == 0) {
+        fprintf(context->output, "Error: Input file '%s' is empty.\n", inputFile);
+        closeSourceFile(&source);
+        return 0;
+    }
+
+    expandSource(&source, output);
+    closeSourceFile(&source);
+    return 1;
 }
 
-// Function to free the macro table memory
-void freeMacroTable(Macro *head) {
-    Macro *current = head;
-    while (current != NULL) {
-        Macro *next = current->next;
-        free(current);
-        current = next;
+// Writes the expanded source to the .am file
+static int writeExpandedFile(char *outputFileName, SourceBuffer *source) {
+    FILE *fpOutput = fopen(outputFileName, "w");
+    size_t offset = 0;
+    char *line;
+
+    if (fpOutput == NULL) {
+        fprintf(context->output, "Error: Unable to create file %s\n", outputFileName);
+        return 0;
+    }
+    while ((line = nextSourceLine(source, &offset)) != NULL) {
+        fprintf(fpOutput, "%s\n", line);
     }
+    fclose(fpOutput);
+    return 1;
 }
 
-// Entry point: Pass input and output files to the pre-assembler
-int preAssembler(char *inputFileName, char *outputFileName) {
-    printf("Running pre-assembler on input: %s, output: %s\n", inputFileName, outputFileName);
+// Function to free the macro table's hash index, the macros are in the file's arena
+void freeMacroTable() {
+    context->macroTable = NULL;
 
-    // Initialize macro table to NULL
-    Macro *macroTable = NULL;
+    trackedFree(context->macroIndex.slots, context->macroIndex.capacity * sizeof(Macro *), ALLOC_MACROS);
+    context->macroIndex.slots = NULL;
+    context->macroIndex.capacity = 0;
+    context->macroIndex.count = 0;
+    context->macroIndex.tail = NULL;
+}
+
+// Entry point: Pass the input file to the pre-assembler. The expanded source is kept in
+// expandedSource for the passes, and also written to outputFileName unless it is NULL
+int preAssembler(char *inputFileName, char *outputFileName) {
+    logMessage(LOG_DEBUG, LOG_PRE, "Running pre-assembler on input: %s\n", inputFileName);
 
     // Initialize counter to 0, it will start from 1 in the process file funct.
-    counter = 0;
+    context->counter = 0;
 
-    // Process the input file and write the result to the output file
-    processFile(inputFileName, outputFileName, macroTable);
+    // Process the input file into the in-memory expanded source.
+    // The macro table is kept until cleanupAssembler, so the first pass can
+    // reject labels that reuse a macro name
+    if (!processFile(inputFileName, &context->expandedSource)) {
+        return 0;
+    }
 
-    // Free the memory used by the macro table
-    freeMacroTable(macroTable);
+    if (outputFileName != NULL && !writeExpandedFile(outputFileName, &context->expandedSource)) {
+        return 0;
+    }
 
-    if (foundError == 1){
+    if (context->foundError == 1){
         return 0;
     } 
     return 1;
 }
+
+// Entry point for a source held in memory: the expanded source is kept in expandedSource,
+// nothing is read from or written to the filesystem
+int preAssembleBuffer(const char *text, size_t length) {
+    SourceFile source;
+
+    // Initialize counter to 0, it will start from 1 in expandSource
+    context->counter = 0;
+
+    if (length == 0) {
+        fprintf(context->output, "Error: Source is empty.\n");
+        return 0;
+    }
+
+    // The text is only read, the caller keeps ownership of it
+    source.text = (char *)text;
+    source.length = length;
+    source.isMapped = 0;
+    expandSource(&source, &context->expandedSource);
+
+    return context->foundError == 0;
+}
@@ -4,20 +4,18 @@
 #include "globals.h"
 #include "dataStructures.h"
 
-int ignorePre(char *line);
-Macro *addToMacroTable(Macro *head, char name[], char content[]);
-void printMacroTable(Macro *head);
-int isMacroName(Macro *head, char *name);
+Macro *addToMacroTable(char name[], char content[]);
+Macro *findMacro(const char *name);
 int isMacroInitialization(char line[]);
 int isReservedOrDeclared(char *macroName);
 int isValidMacroName(char *macroName);
-Macro* insertMacroName(Macro* head, char line[]);
-void insertMacroContent(Macro *head, char line[]);
-void processFile(char *inputFile, char *outputFile, Macro *head);
+Macro* insertMacroName(char line[]);
+void insertMacroContent(Macro *macro, char line[]);
+void expandSource(const SourceFile *source, SourceBuffer *output);
+int processFile(char *inputFile, SourceBuffer *output);
 int isEndMacro(char line[]);
-void replaceMacro(Macro *head, char *macroName, char *replacedLine);
-void writeFile(char *inputFileName, Macro *head);
+void freeMacroTable();
 int preAssembler(char *inputFileName, char *outputFileName);
-void trimTrailingNewline(char *str);
+int preAssembleBuffer(const char *text, size_t length);
 
 #endif 
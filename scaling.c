@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/stat.h>
+#include "scaling.h"
+
+// Sizes assembled when none are given on the command line. The smallest one takes
+// about ten times the resolution of the CPU time, so its measurement is meaningful
+static const long defaultSizes[] = {50000, 200000, 1000000};
+
+/**
+ * @brief Generates the default workload with 'lines' body lines and assembles it 'runs' times.
+ *
+ * The fastest run gives the time and the smallest peak RSS is kept, so a run slowed
+ * down by the rest of the machine doesn't look like a regression.
+ *
+ * @return int 1 if every run succeeded.
+ */
+int measurePoint(const char *assembler, const char *directory, long lines, int runs, ScalingPoint *point) {
+    WorkloadConfig config;
+    char name[WORKLOAD_NAME_LENGTH];
+    char baseFile[256];
+
+    snprintf(name, sizeof(name), "scale-%ld", lines);
+    defaultWorkloadConfig(&config, name, lines);
+    snprintf(baseFile, sizeof(baseFile), "%s/%s", directory, name);
+    if (!writeWorkload(&config, baseFile, &point->lines)) {
+        return 0;
+    }
+
+    for (int run = 0; run < runs; run++) {
+        RunResult measured;
+        if (!runAssembler(assembler, baseFile, &measured)) {
+            printf("Error: %s failed on %s.asm\n", assembler, baseFile);
+            return 0;
+        }
+        if (run == 0 || measured.cpuSeconds < point->cpuSeconds) {
+            point->cpuSeconds = measured.cpuSeconds;
+        }
+        if (run == 0 || measured.peakKb < point->peakKb) {
+            point->peakKb = measured.peakKb;
+        }
+    }
+    return 1;
+}
+
+// Returns the measured time, or the peak RSS if 'memory' is set. A time below the
+// resolution of the clock reads as the resolution, so its logarithm is defined
+static double pointValue(const ScalingPoint *point, int memory) {
+    if (memory) {
+        return point->peakKb > 0 ? (double)point->peakKb : 1.0;
+    }
+    return point->cpuSeconds > MIN_CPU_SECONDS ? point->cpuSeconds : MIN_CPU_SECONDS;
+}
+
+static int compareSizes(const void *a, const void *b) {
+    long first = *(const long *)a, second = *(const long *)b;
+    return (first > second) - (first < second);
+}
+
+/**
+ * @brief Fits value = c * lines^k over the points by least squares on log-log scale.
+ *
+ * @return double The exponent k: 1 for linear growth, 2 for quadratic growth.
+ */
+double fitExponent(const ScalingPoint *points, int count, int memory) {
+    double sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+
+    for (int i = 0; i < count; i++) {
+        double x = log((double)points[i].lines);
+        double y = log(pointValue(&points[i], memory));
+        sumX += x;
+        sumY += y;
+        sumXX += x * x;
+        sumXY += x * y;
+    }
+    return (count * sumXY - sumX * sumY) / (count * sumXX - sumX * sumX);
+}
+
+// Returns the growth exponent between two consecutive sizes
+double stepExponent(const ScalingPoint *from, const ScalingPoint *to, int memory) {
+    return log(pointValue(to, memory) / pointValue(from, memory)) / log((double)to->lines / from->lines);
+}
+
+// Prints an exponent and returns 1 if it is within 1 + tolerance
+static int checkExponent(const char *what, double exponent, double tolerance) {
+    int linear = exponent <= 1.0 + tolerance;
+    printf("  %-28s %6.2f  %s\n", what, exponent, linear ? "ok" : "SUPER-LINEAR");
+    return linear;
+}
+
+static void printUsage(const char *program) {
+    printf("Usage: %s [--assembler PATH] [--dir DIR] [--runs N] [--tolerance T] [LINES...]\n"
+           "Fails if the CPU time or the peak RSS grows faster than lines^(1 + T), T is 0.3 by default\n", program);
+}
+
+// Assembles generated inputs of growing size and checks that time and memory grow linearly
+int main(int argc, char *argv[]) {
+    const char *assembler = "./assembler";
+    const char *directory = "scaling_workloads";
+    int runs = 2;
+    double tolerance = 0.3;
+    long sizes[MAX_SCALING_SIZES];
+    ScalingPoint points[MAX_SCALING_SIZES];
+    int numOfSizes = 0, passed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        int hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--assembler") == 0 && hasValue) {
+            assembler = argv[++i];
+        } else if (strcmp(argv[i], "--dir") == 0 && hasValue) {
+            directory = argv[++i];
+        } else if (strcmp(argv[i], "--runs") == 0 && hasValue) {
+            runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--tolerance") == 0 && hasValue) {
+            tolerance = atof(argv[++i]);
+        } else if (atol(argv[i]) > 0 && numOfSizes < MAX_SCALING_SIZES) {
+            sizes[numOfSizes++] = atol(argv[i]);
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (runs < 1) {
+        printf("Error: '--runs' expects a positive number.\n");
+        return 1;
+    }
+    if (numOfSizes == 0) {
+        numOfSizes = (int)(sizeof(defaultSizes) / sizeof(defaultSizes[0]));
+        memcpy(sizes, defaultSizes, sizeof(defaultSizes));
+    }
+    if (numOfSizes < 2) {
+        printf("Error: At least two sizes are needed to fit the growth.\n");
+        return 1;
+    }
+    // The steps go from each size to the next larger one, equal sizes have no growth to measure
+    qsort(sizes, numOfSizes, sizeof(long), compareSizes);
+    for (int i = 1; i < numOfSizes; i++) {
+        if (sizes[i] == sizes[i - 1]) {
+            printf("Error: Size %ld is given twice.\n", sizes[i]);
+            return 1;
+        }
+    }
+
+    mkdir(directory, 0777);  // Usually exists already
+    printf("%12s %10s %10s\n", "lines", "cpu s", "peak KB");
+    for (int i = 0; i < numOfSizes; i++) {
+        if (!measurePoint(assembler, directory, sizes[i], runs, &points[i])) {
+            return 1;
+        }
+        printf("%12ld %10.3f %10ld%s\n", points[i].lines, points[i].cpuSeconds, points[i].peakKb,
+               points[i].cpuSeconds < 10 * MIN_CPU_SECONDS ? "  (close to the clock resolution)" : "");
+    }
+
+    // The fit catches growth over the whole range, the steps catch a path that only
+    // turns quadratic on the largest inputs
+    printf("Growth exponents (1.00 is linear, tolerance %.2f):\n", tolerance);
+    passed &= checkExponent("cpu time, fit", fitExponent(points, numOfSizes, 0), tolerance);
+    passed &= checkExponent("peak RSS, fit", fitExponent(points, numOfSizes, 1), tolerance);
+    for (int i = 1; i < numOfSizes; i++) {
+        char what[64];
+        snprintf(what, sizeof(what), "cpu time, %ld -> %ld", sizes[i - 1], sizes[i]);
+        passed &= checkExponent(what, stepExponent(&points[i - 1], &points[i], 0), tolerance);
+        snprintf(what, sizeof(what), "peak RSS, %ld -> %ld", sizes[i - 1], sizes[i]);
+        passed &= checkExponent(what, stepExponent(&points[i - 1], &points[i], 1), tolerance);
+    }
+
+    printf(passed ? "Scaling check passed.\n" : "Scaling check failed: growth is super-linear.\n");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,21 @@
+#ifndef SCALING_H
+#define SCALING_H
+
+#include "workload.h"
+
+#define MAX_SCALING_SIZES 8      // Input sizes in one run
+#define MIN_CPU_SECONDS 0.004  // Resolution of the CPU times of getrusage (one tick at 250 Hz)
+
+// Measurements of the assembler at one input size
+typedef struct ScalingPoint {
+    long lines;          // Source lines of the generated workload
+    double cpuSeconds;   // CPU time of the fastest run
+    long peakKb;         // Smallest peak RSS over the runs
+} ScalingPoint;
+
+int measurePoint(const char *assembler, const char *directory, long lines, int runs, ScalingPoint *point);
+double fitExponent(const ScalingPoint *points, int count, int memory);
+double stepExponent(const ScalingPoint *from, const ScalingPoint *to, int memory);
+int main(int argc, char *argv[]);
+
+#endif // SCALING_H
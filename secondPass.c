@@ -10,59 +10,44 @@
 
 
 
-void secondPass(char *sourceFile) {
+void secondPass(SourceBuffer *source) {
+    size_t offset = 0;
+    char *line;
+
     // Step 1: Initiate IC
-    IC = 100;
-    FILE *file = fopen(sourceFile, "r");
-    if (file == NULL) {
-        printf("Error: Could not open source file: %s\n", sourceFile);
-        return;
-    }
-    
-    char line[MAX];
+    context->IC = 100;
     
-    // Step 2: Read each line from the source file
-    while (fgets(line, sizeof(line), file) != NULL) {
+    // Step 2: Read each line of the expanded source
+    while ((line = nextSourceLine(source, &offset)) != NULL) {
         // Step 3-8: Process each line using the processLineSecondPass function
         processLineSecondPass(line);
     }
     
-    // Step 9: After reading the file, check for errors
-    if (foundError) {
-        printf("Errors found during the second pass.\n");
-        fclose(file);
+    // Step 9: After reading the source, check for errors
+    if (context->foundError) {
+        fprintf(context->output, "Errors found during the second pass.\n");
         return;
     }
     
     // Step 10: Build the output files (this will be handled later)
-    fclose(file);
-    printf("Second pass completed successfully.\n");
+    logMessage(LOG_DEBUG, LOG_SECOND, "Second pass completed successfully.\n");
 }
 
 void processLineSecondPass(char *line) {
-    printf("processing line: %s\n", line);
-    char firstWord[MAX];
-    sscanf(line, "%s", firstWord);
-    int num = determineLineType(line);
+    logMessage(LOG_DEBUG, LOG_SECOND, "processing line: %s\n", line);
+    LineRecord record;
+    int num = parseLine(line, &record);
     int L = 0;
-    printf("line type: %d\n", num);
-
-    // Step 3: Check if the first word is a symbol
-    if (isSymbolFormat(firstWord)) {
-        // Skip the symbol and get the next word
-        line = skipFirstWord(line);
-        sscanf(line, "%s", firstWord);
-    }
-    printf("first word now is: %s\n", firstWord); // Debug line
+    logMessage(LOG_DEBUG, LOG_SECOND, "line type: %d\n", num);
 
     // Step 4: Skip .data, .string, and directives
-    if (num == 0 || num == 1) {
-        printf("Skip second pass\n");
+    if (num == LINE_COMMENT || num == LINE_DATA) {
+        logMessage(LOG_DEBUG, LOG_SECOND, "Skip second pass\n");
         return;  // Skip this line, return to secondPass
     }
-    if (num == 2) {
+    if (num == LINE_EXTERN_ENTRY) {
         // Step 5: Handle .entry directive
-        if (strstr(firstWord, ".entry") != NULL) {  // Use strstr to be more flexible
+        if (record.directive == DIRECTIVE_ENTRY) {
             parseEntryLine(line);
             return;
         } else { // .extern
@@ -70,20 +55,19 @@ void processLineSecondPass(char *line) {
         }
     }
 
-    printf("Trying to debug\n");
-    // Step 6: Decoding operands (This is where we'll decode the second word and beyond)
-    // Find symbols in the symbol table, raise error if not found.
-    // This part will be expanded later with operand decoding logic.
-    if (num == 3){ //That means it's an opcode line
-        printf("Opcode line\n");
-        L = parseOpcodeSecondPass(line);
+    // Step 6: Decoding operands (the second word and beyond),
+    // find symbols in the symbol table, raise error if not found.
+    if (num == LINE_OPCODE){ //That means it's an opcode line
+        logMessage(LOG_DEBUG, LOG_SECOND, "Opcode line\n");
+        L = parseOpcodeSecondPass(&record);
     }
     // Step 8: Update IC
-    IC += L;
+    context->IC += L;
 }
 
 void parseEntryLine(const char *line) {
-    char *lineCopy = strdup(line);  // Create a modifiable copy of the line
+    ArenaMark mark = arenaMark(context->arena);
+    char *lineCopy = arenaStrdup(context->arena, line, ALLOC_SOURCE);  // Create a modifiable copy of the line
     char *linePtr = lineCopy;
     char symbolName[MAX];
     int commaRequired = 0;  // No comma required before the first label
@@ -97,31 +81,31 @@ void parseEntryLine(const char *line) {
     // Parse the labels after ".entry"
     while (*linePtr != '\0') {
         if (!skipComma(&linePtr, commaRequired)) {
-            free(lineCopy);
+            arenaRelease(context->arena, mark);
             return;  // Error with commas
         }
 
-        // Extract the label
-        if (sscanf(linePtr, "%[^, \t\n]", symbolName) != 1) {
-            printf("Error: Expected a label.\n");
-            free(lineCopy);
+        // Extract the label (names that don't fit can't be in the table anyway)
+        if (sscanf(linePtr, "%79[^, \t\n]", symbolName) != 1) {
+            fprintf(context->output, "Error: Expected a label.\n");
+            arenaRelease(context->arena, mark);
             return;  // Error parsing label
         }
 
-        printf("Checking symbol: %s\n", symbolName);
+        logMessage(LOG_DEBUG, LOG_SECOND, "Checking symbol: %s\n", symbolName);
 
         // Find the symbol in the symbol table
         Symbol *symbol = findSymbol(symbolName);  // Function to find a symbol in the table
         if (symbol) {
-            // Mark the symbol as 'entry'
-            strcpy(symbol->properties[2], "entry");
-            printf("Symbol '%s' marked as 'entry'\n", symbolName);
+            // Mark the symbol as 'entry', listing it for the .ent file
+            markEntrySymbol(symbol);
+            logMessage(LOG_DEBUG, LOG_SECOND, "Symbol '%s' marked as 'entry'\n", symbolName);
         } else {
-            printf("Error: Symbol '%s' not found in symbol table.\n", symbolName);
+            fprintf(context->output, "Error: Symbol '%s' not found in symbol table.\n", symbolName);
         }
 
         // Move the linePtr past the current label
-        linePtr += strlen(symbolName);
+        linePtr += strcspn(linePtr, ", \t\n");
 
         // Skip any trailing whitespace
         while (*linePtr == ' ' || *linePtr == '\t') {
@@ -132,67 +116,62 @@ void parseEntryLine(const char *line) {
         commaRequired = 1;
     }
 
-    free(lineCopy);
+    arenaRelease(context->arena, mark);
 }
 
-// Handle Direct Addressing Mode (label)
-void handleDirectAddressing(char *operand, int position) {
-    // Find the symbol in the symbol table
-    Symbol *symbol = findSymbol(operand);
-    
-    // If the symbol is not found, raise an error and return
-    if (symbol == NULL) {
-        printf("Error: Symbol '%s' not found\n", operand);
-        return;
-    }
+// Encodes the word of a label operand (DIRECT or RELATIVE) once its symbol is known
+void encodeSymbolOperand(Symbol *symbol, int addressingMode, int position) {
+    Word machineWord;
 
-    // Allocate memory for a 24-bit binary string (+1 for the null terminator)
-    char *binaryWord = (char *)malloc(25 * sizeof(char));
-    if (binaryWord == NULL) {
-        printf("Memory allocation failed\n");
-        exit(1);
-    }
-
-    // Initialize the binaryWord with 0s and null-terminate the string
-    memset(binaryWord, '0', 24);
-    binaryWord[24] = '\0';
-
-    // Get the symbol value
-    int value = symbol->value;
+    if (addressingMode == RELATIVE) {
+        // Relative addressing can't be used with external symbols
+        if (isExternal(symbol)) {
+            fprintf(context->output, "Error: Symbol '%s' is external, relative addressing cannot be used with external symbols\n", nameText(symbol->name));
+            return;
+        }
 
-    // Convert the symbol value into a 21-bit binary string and store it in the leftmost 21 bits
-    for (int i = 20; i >= 0; i--) {
-        binaryWord[i] = (value & 1) ? '1' : '0';  // Extract the least significant bit
-        value >>= 1;  // Right shift the number to get the next bit
+        // Calculate the relative distance (label address - current position)
+        int distance = symbol->value - (position-1);
+        logMessage(LOG_DEBUG, LOG_SECOND, "Symbol value is %d, position is %d, distance is %d\n", symbol->value, position-1, distance);
+        // Store the 21-bit signed distance in the leftmost bits, A,R,E is '100' (absolute)
+        updateInstruction(position, PACK_OPERAND(distance, ARE_ABSOLUTE));
+        return;
     }
 
-    // Set the last 3 bits (A, R, E)
+    // The symbol value takes the leftmost 21 bits, followed by the A,R,E bits
     if (isExternal(symbol)) {
-        binaryWord[21] = '0';  // A = 0
-        binaryWord[22] = '0';  // R = 0
-        binaryWord[23] = '1';  // E = 1 (external symbol)
+        machineWord = PACK_OPERAND(symbol->value, ARE_EXTERNAL);  // E = 1 (external symbol)
 
         // Record the external symbol usage
-        addExternalReference(operand, position);
+        addExternalReference(symbol->name, position);
 
     } else {
-        binaryWord[21] = '0';  // A = 0
-        binaryWord[22] = '1';  // R = 1 (relocatable symbol)
-        binaryWord[23] = '0';  // E = 0
+        machineWord = PACK_OPERAND(symbol->value, ARE_RELOCATABLE);  // R = 1 (relocatable symbol)
     }
 
     // Update the instruction at the given position
-    updateInstruction(position, binaryWord);
+    updateInstruction(position, machineWord);
+}
 
-    // Free the allocated memory for the binaryWord
-    free(binaryWord);
+// Handle Direct Addressing Mode (label)
+void handleDirectAddressing(char *operand, int position) {
+    // Find the symbol in the symbol table
+    Symbol *symbol = findSymbol(operand);
+    
+    // If the symbol is not found, raise an error and return
+    if (symbol == NULL) {
+        fprintf(context->output, "Error: Symbol '%s' not found\n", operand);
+        return;
+    }
+
+    encodeSymbolOperand(symbol, DIRECT, position);
 }
 
 // Handle Relative Addressing Mode (&label)
 void handleRelativeAddressing(char *operand, int position) {
     // Ensure the operand starts with '&'
     if (operand[0] != '&') {
-        printf("Error: Invalid operand format for relative addressing: '%s'\n", operand);
+        fprintf(context->output, "Error: Invalid operand format for relative addressing: '%s'\n", operand);
         return;
     }
 
@@ -202,51 +181,18 @@ void handleRelativeAddressing(char *operand, int position) {
     // Find the symbol in the symbol table
     Symbol *symbol = findSymbol(label);
     
-    // Ensure the symbol exists and is not external
+    // Ensure the symbol exists
     if (symbol == NULL) {
-        printf("Error: Symbol '%s' not found\n", label);
+        fprintf(context->output, "Error: Symbol '%s' not found\n", label);
         return;
     }
-    if (isExternal(symbol)) {
-        printf("Error: Symbol '%s' is external, relative addressing cannot be used with external symbols\n", label);
-        return;
-    }
-
-    // Calculate the relative distance (label address - current position)
-    int distance = symbol->value - (position-1);
-    printf("Symbol value is %d, position is %d, distance is %d\n", symbol->value, position-1, distance);
-    // Convert the distance to 21-bit binary
-    char *binaryWord = (char *)malloc(25 * sizeof(char));  // 24 bits + null terminator
-    if (binaryWord == NULL) {
-        printf("Memory allocation failed\n");
-        exit(1);
-    }
-    memset(binaryWord, '0', 24);  // Initialize all to '0'
-    binaryWord[24] = '\0';  // Null-terminate the string
-
-    //Placeholder: create a function that converts integer to 21bit binary
-
-    // Convert the distance to a 21-bit signed binary and store it in the leftmost 21 bits
-    for (int i = 20; i >= 0; i--) {
-        binaryWord[i] = (distance & 1) ? '1' : '0';  // Extract each bit from the distance
-        distance >>= 1;  // Shift right to get the next bit
-    }
 
-    // Set the last 3 bits to '100' (absolute addressing for relative mode)
-    binaryWord[21] = '1';  // A = 1
-    binaryWord[22] = '0';  // R = 0
-    binaryWord[23] = '0';  // E = 0
-
-    // Update the instruction at the given position with the new machine code
-    updateInstruction(position, binaryWord);
-
-    // Free allocated memory
-    free(binaryWord);
+    encodeSymbolOperand(symbol, RELATIVE, position);
 }
 
 // Main function to decode the operand and update the machine code based on the addressing mode
 void decodeOperandToMachineCode(char *operand, int addressingMode, int position) {
-    printf("Decoding operand: '%s' at position: %d with addressing mode: %d\n", operand, position, addressingMode);
+    logMessage(LOG_DEBUG, LOG_SECOND, "Decoding operand: '%s' at position: %d with addressing mode: %d\n", operand, position, addressingMode);
     switch (addressingMode) {
         case IMMEDIATE:
             // Already decoded in first pass
@@ -261,71 +207,67 @@ void decodeOperandToMachineCode(char *operand, int addressingMode, int position)
             // Already decoded in first pass
             break;
         default:
-            printf("Error: Unknown addressing mode %d\n", addressingMode);
+            fprintf(context->output, "Error: Unknown addressing mode %d\n", addressingMode);
             break;
     }
     return;
 }
 
-int parseOpcodeSecondPass(char *line) {
-    char label[MAX_SYMBOL_LENGTH] = "";  // Optional label
-    char opcodeName[MAX_SYMBOL_LENGTH] = "";
-    char operand1[MAX_SYMBOL_LENGTH] = "";  // Source operand
-    char operand2[MAX_SYMBOL_LENGTH] = "";  // Target operand
-    int numOperands = 0;
+int parseOpcodeSecondPass(LineRecord *record) {
+    const Opcode *opcode = record->opcode;
+    int mode1 = record->sourceMode, mode2 = record->targetMode;
 
-    sscanf(line, "%s", label);
+    logMessage(LOG_DEBUG, LOG_SECOND, "Found Opcode: %s\n", opcode->name);
+    logMessage(LOG_DEBUG, LOG_SECOND, "Addressing modes: mode1=%d, mode2=%d\n", mode1, mode2);
 
-    // Step 1: Check if there is a label
-    if (isSymbolFormat(label)) {
-        line = skipFirstWord(line);
-        printf("testing\n");
-    }
+    int L = calculateL(opcode, mode1, mode2);
+    logMessage(LOG_DEBUG, LOG_SECOND, "Number of words (L): %d\n", L);
 
-    // Step 2: Extract the opcode
-    sscanf(line, "%s", opcodeName);
-    Opcode *opcode = findOpcode(opcodeName);
-    if (opcode == NULL) {
-        raiseError("Error: Unknown opcode '%s'.\n", opcodeName);
-        return 1;
+    // Decode the operands from the second word to L
+    if (opcode->numOfOperands == 2) {
+        decodeOperandToMachineCode(record->sourceOperand, mode1, context->IC + 1);  // Decode first operand
+    }
+    if (opcode->numOfOperands >= 1) {
+        decodeOperandToMachineCode(record->targetOperand, mode2, targetOperandAddress(record, context->IC));
     }
 
-    printf("Found Opcode: %s\n", opcodeName);
+    return L;  // Return the number of words decoded
+}
 
-    // Step 3: Check the number of operands based on the opcode
-    int mode1 = -1, mode2 = -1;
-    int L = 1;  // Start with 1 for the first word
+// Single-pass mode: patches a label operand now if its symbol is a code label that is
+// already defined (a backward reference), otherwise records it as a fixup. Data labels
+// are deferred too since they are only relocated by ICF at the end of the first pass,
+// and external labels so the .ext list stays in address order
+void resolveOrDeferOperand(char *operand, int addressingMode, int position) {
+    if (addressingMode != DIRECT && addressingMode != RELATIVE) {
+        return;  // Immediate and register operands are already encoded
+    }
 
-    if (opcode->numOfOperands == 2) {
-        sscanf(line + strlen(opcodeName), " %[^,], %s", operand1, operand2);
-        printf("Operands: '%s', '%s'\n", operand1, operand2);
-        mode1 = findAddressingMode(operand1);  // Addressing mode for source operand
-        mode2 = findAddressingMode(operand2);  // Addressing mode for target operand
-        printf("Addressing modes: mode1=%d, mode2=%d\n", mode1, mode2);
-
-    } else if (opcode->numOfOperands == 1) {
-        sscanf(line + strlen(opcodeName), "%s", operand2);  // Operand2 is target
-        printf("Operand: '%s'\n", operand2);
-        mode2 = findAddressingMode(operand2);  // Addressing mode for target operand
-        printf("Addressing mode: mode2=%d\n", mode2);
+    // The label is interned either way, a fixup keeps only its id
+    NameId label = internName(addressingMode == RELATIVE ? operand + 1 : operand);
+    Symbol *symbol = findSymbolById(label);
+    if (symbol != NULL && (symbol->attributes & SYMBOL_CODE)) {
+        encodeSymbolOperand(symbol, addressingMode, position);
+    } else {
+        addFixup(label, position, addressingMode);
     }
+}
 
-    L = calculateL(opcode, mode1, mode2);
-    printf("Number of words (L): %d\n", L);
+// Single-pass mode: applies the deferred .entry lines and patches every recorded
+// fixup, once the first pass has completed the symbol table
+void resolveFixups() {
+    for (int i = 0; i < context->fixupList.entryCount; i++) {
+        parseEntryLine(context->fixupList.entryLines[i]);
+    }
 
-    // Start decoding the operands from the second word to L
-    /*int position = 1;  // Start at the second word (index 1, as index 0 is the first word)*/
-    if (opcode->numOfOperands == 2) {
-        decodeOperandToMachineCode(operand1, mode1, IC + 1);  // Decode first operand
-        if (mode1 == REGISTER) {
-            decodeOperandToMachineCode(operand2, mode2, IC + 1);  // Decode second operand
-        } else {
-            decodeOperandToMachineCode(operand2, mode2, IC + 2);  // Decode second operand
+    // Fixups are in address order, so external references are recorded in order too
+    for (int i = 0; i < context->fixupList.count; i++) {
+        Fixup *fixup = &context->fixupList.fixups[i];
+        Symbol *symbol = findSymbolById(fixup->label);
+        if (symbol == NULL) {
+            fprintf(context->output, "Error: Symbol '%s' not found\n", nameText(fixup->label));
+            continue;
         }
-    } else if (opcode->numOfOperands == 1) {
-        decodeOperandToMachineCode(operand2, mode2, IC + 1);  // Decode single operand
+        encodeSymbolOperand(symbol, fixup->mode, fixup->address);
     }
-
-    return L;  // Return the number of words decoded
 }
-
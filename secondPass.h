@@ -8,8 +8,8 @@
 #include "util.h"
 #include "firstPass.h"
 
-// Function to initiate the second pass of the assembler
-void secondPass(char *sourceFile);
+// Function to initiate the second pass of the assembler over the expanded source
+void secondPass(SourceBuffer *source);
 
 // Function to process each line during the second pass
 void processLineSecondPass(char *line);
@@ -21,6 +21,7 @@ void parseEntryLine(const char *line);
 void convertToBinary(int value, char *binaryWord, int start, int length);
 
 // Functions to handle various addressing modes
+void encodeSymbolOperand(Symbol *symbol, int addressingMode, int position);
 void handleDirectAddressing(char *operand, int wordIndex);
 void handleRelativeAddressing(char *operand, int position);
 
@@ -28,6 +29,12 @@ void handleRelativeAddressing(char *operand, int position);
 void decodeOperandToMachineCode(char *operand, int addressingMode, int position);  // Corrected signature
 
 // Function to parse and process opcode lines in the second pass
-int parseOpcodeSecondPass(char *line);
+int parseOpcodeSecondPass(LineRecord *record);
+
+// Single-pass mode: patches a label operand now or records it as a fixup
+void resolveOrDeferOperand(char *operand, int addressingMode, int position);
+
+// Single-pass mode: applies deferred .entry lines and patches all fixups
+void resolveFixups();
 
 #endif // SECONDPASS_H
@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sourceReader.h"
+#include "allocator.h"
+
+/**
+ * @brief Reads everything left in a file descriptor into one allocated buffer.
+ *
+ * Used for inputs that can't be mapped, such as pipes.
+ *
+ * @return int 1 on success, 0 on a read error.
+ */
+static int readWholeFile(int fd, SourceFile *file) {
+    ssize_t bytesRead;
+
+    do {
+        if (file->length == file->capacity) {
+            size_t newCapacity = (file->capacity > 0) ? file->capacity * 2 : 4096;
+            file->text = (char *)trackedRealloc(file->text, file->capacity, newCapacity, ALLOC_SOURCE);
+            file->capacity = newCapacity;
+        }
+        bytesRead = read(fd, file->text + file->length, file->capacity - file->length);
+        if (bytesRead > 0) {
+            file->length += (size_t)bytesRead;
+        }
+    } while (bytesRead > 0);
+
+    return bytesRead == 0;
+}
+
+/**
+ * @brief Opens a source file and makes its whole content available in memory.
+ *
+ * Regular files are mapped read-only, anything else is read in one bulk read.
+ * An empty file opens successfully with a length of 0.
+ *
+ * @param fileName Name of the file to open.
+ * @param file Pointer to the source file to fill.
+ * @return int 1 on success, 0 if the file can't be opened or read.
+ */
+int openSourceFile(const char *fileName, SourceFile *file) {
+    struct stat info;
+    int fd;
+    int success = 1;
+
+    file->text = NULL;
+    file->length = 0;
+    file->isMapped = 0;
+    file->capacity = 0;
+
+    fd = open(fileName, O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+        if (info.st_size > 0) {
+            void *mapped = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                file->text = (char *)mapped;
+                file->length = (size_t)info.st_size;
+                file->isMapped = 1;
+            } else {
+                success = readWholeFile(fd, file);  // Fall back to a bulk read
+            }
+        }
+    } else {
+        success = readWholeFile(fd, file);
+    }
+
+    close(fd);
+    if (!success) {
+        closeSourceFile(file);
+    }
+    return success;
+}
+
+/**
+ * @brief Hands out the line starting at *offset as a view over the file content.
+ *
+ * The view doesn't include the '\n' and isn't null-terminated.
+ *
+ * @param file Pointer to the open source file.
+ * @param offset Position of the line, moved to the start of the next line.
+ * @param view Pointer to the view to fill.
+ * @return int 1 if a line was returned, 0 at the end of the file.
+ */
+int nextLineView(const SourceFile *file, size_t *offset, LineView *view) {
+    const char *start;
+    const char *newline;
+    size_t remaining;
+
+    if (*offset >= file->length) {
+        return 0;
+    }
+
+    start = file->text + *offset;
+    remaining = file->length - *offset;
+    newline = (const char *)memchr(start, '\n', remaining);
+
+    view->start = start;
+    view->length = (newline != NULL) ? (size_t)(newline - start) : remaining;
+    *offset += view->length + 1;  // Skip the '\n'
+    return 1;
+}
+
+/**
+ * @brief Unmaps or frees the content of a source file.
+ */
+void closeSourceFile(SourceFile *file) {
+    if (file->isMapped) {
+        munmap(file->text, file->length);
+    } else {
+        trackedFree(file->text, file->capacity, ALLOC_SOURCE);
+    }
+    file->text = NULL;
+    file->length = 0;
+    file->isMapped = 0;
+    file->capacity = 0;
+}
@@ -0,0 +1,9 @@
+#ifndef SOURCEREADER_H
+#define SOURCEREADER_H
+#include "dataStructures.h"
+
+int openSourceFile(const char *fileName, SourceFile *file);
+int nextLineView(const SourceFile *file, size_t *offset, LineView *view);
+void closeSourceFile(SourceFile *file);
+
+#endif
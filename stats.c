@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "stats.h"
+#include "globals.h"
+
+// Names of the phases, in the table and in the JSON keys
+static const char *phaseNames[NUM_OF_PHASES] = {"pre-assembler", "first pass", "second pass", "output", "total"};
+static const char *phaseKeys[NUM_OF_PHASES] = {"pre", "first", "second", "output", "total"};
+static const char *allocationKeys[NUM_OF_ALLOC_KINDS] = {
+    "names", "macros", "code", "data", "fixups", "source", "arena", "output", "externals"
+};
+
+// Reads a clock in seconds
+static double readClock(clockid_t clock) {
+    struct timespec now;
+    clock_gettime(clock, &now);
+    return (double)now.tv_sec + now.tv_nsec / 1e9;
+}
+
+void startPhaseTimer(FileStats *stats, int phase) {
+    stats->phase = phase;
+    // A phase's peak memory includes what it started with, even if it allocates nothing
+    if (stats->totalAllocations.live > stats->phaseAllocations[phase].peak) {
+        stats->phaseAllocations[phase].peak = stats->totalAllocations.live;
+    }
+    stats->wallStart[phase] = readClock(CLOCK_MONOTONIC);
+    stats->cpuStart[phase] = readClock(CLOCK_THREAD_CPUTIME_ID);
+}
+
+// Adds the time since startPhaseTimer to the phase, a phase may run more than once
+void endPhaseTimer(FileStats *stats, int phase) {
+    stats->wallSeconds[phase] += readClock(CLOCK_MONOTONIC) - stats->wallStart[phase];
+    stats->cpuSeconds[phase] += readClock(CLOCK_THREAD_CPUTIME_ID) - stats->cpuStart[phase];
+    stats->phase = PHASE_TOTAL;
+}
+
+// Copies the counters kept by the tables of the current context, before they are freed
+void collectFileStats(FileStats *stats) {
+    stats->macroExpansions = context->macroIndex.expansions;
+    stats->symbolLookups = context->namePool.lookups;
+    stats->fixups = context->fixupList.count;
+    stats->codeWords = context->codeImage.count;
+    stats->dataWords = context->dataImage.count;
+    for (int kind = 0; kind < NUM_OF_ALLOC_KINDS; kind++) {
+        stats->liveAtCleanup[kind] = stats->allocations[kind].live;
+        stats->arenaAllocations[kind].live = (long)context->arena->allocated[kind];
+    }
+}
+
+// Prints a JSON string: the text in quotes, with quotes, backslashes and control characters escaped
+static void printJsonString(FILE *stream, const char *text) {
+    fputc('"', stream);
+    for (const unsigned char *c = (const unsigned char *)text; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            fprintf(stream, "\\%c", *c);
+        } else if (*c < 0x20) {
+            fprintf(stream, "\\u%04x", *c);
+        } else {
+            fputc(*c, stream);
+        }
+    }
+    fputc('"', stream);
+}
+
+// Prints the allocation counters of a file (--memory)
+static void printAllocationStats(FILE *stream, const FileStats *stats, int format) {
+    const AllocationCounters *total = &stats->totalAllocations;
+
+    if (format == STATS_JSON) {
+        for (int i = 0; i < NUM_OF_PHASES; i++) {
+            const AllocationCounters *phase = &stats->phaseAllocations[i];
+            const char *key = (i == PHASE_TOTAL) ? "other" : phaseKeys[i];
+            fprintf(stream, ",\"%s_allocs\":%ld,\"%s_alloc_bytes\":%ld,\"%s_peak_bytes\":%ld",
+                    key, phase->count, key, phase->bytes, key, phase->peak);
+        }
+        for (int kind = 0; kind < NUM_OF_ALLOC_KINDS; kind++) {
+            const AllocationCounters *counters = &stats->allocations[kind];
+            const AllocationCounters *arena = &stats->arenaAllocations[kind];
+            fprintf(stream, ",\"%s_allocs\":%ld,\"%s_alloc_bytes\":%ld,\"%s_live_bytes\":%ld,\"%s_peak_bytes\":%ld",
+                    allocationKeys[kind], counters->count, allocationKeys[kind], counters->bytes,
+                    allocationKeys[kind], stats->liveAtCleanup[kind], allocationKeys[kind], counters->peak);
+            fprintf(stream, ",\"%s_arena_allocs\":%ld,\"%s_arena_bytes\":%ld,\"%s_arena_live_bytes\":%ld",
+                    allocationKeys[kind], arena->count, allocationKeys[kind], arena->bytes,
+                    allocationKeys[kind], arena->live);
+        }
+        fprintf(stream, ",\"allocs\":%ld,\"alloc_bytes\":%ld,\"peak_bytes\":%ld",
+                total->count, total->bytes, total->peak);
+        return;
+    }
+
+    // The arena columns are the allocations taken from the arena blocks, which are counted in the arena row
+    fprintf(stream, "  %-14s %10s %10s %10s %10s %10s %10s %10s\n", "allocations", "count", "KB", "live KB",
+            "peak KB", "arena n", "arena KB", "arena live");
+    for (int i = 0; i < NUM_OF_PHASES; i++) {
+        const AllocationCounters *phase = &stats->phaseAllocations[i];
+        fprintf(stream, "  %-14s %10ld %10.1f %10s %10.1f\n", i == PHASE_TOTAL ? "other" : phaseNames[i],
+                phase->count, phase->bytes / 1024.0, "", phase->peak / 1024.0);
+    }
+    for (int kind = 0; kind < NUM_OF_ALLOC_KINDS; kind++) {
+        const AllocationCounters *counters = &stats->allocations[kind];
+        const AllocationCounters *arena = &stats->arenaAllocations[kind];
+        fprintf(stream, "  %-14s %10ld %10.1f %10.1f %10.1f %10ld %10.1f %10.1f\n", allocationKindName(kind),
+                counters->count, counters->bytes / 1024.0, stats->liveAtCleanup[kind] / 1024.0,
+                counters->peak / 1024.0, arena->count, arena->bytes / 1024.0, arena->live / 1024.0);
+    }
+    fprintf(stream, "  %-14s %10ld %10.1f %10s %10.1f\n", "total", total->count, total->bytes / 1024.0, "",
+            total->peak / 1024.0);
+}
+
+/**
+ * @brief Prints the times and counters of a file.
+ *
+ * @param format STATS_TABLE or STATS_JSON.
+ */
+void printFileStats(FILE *stream, const char *fileName, int succeeded, const FileStats *stats, int format) {
+    if (format == STATS_JSON) {
+        fprintf(stream, "{\"file\":");
+        printJsonString(stream, fileName);
+        fprintf(stream, ",\"succeeded\":%s", succeeded ? "true" : "false");
+        for (int i = 0; i < NUM_OF_PHASES; i++) {
+            fprintf(stream, ",\"%s_wall_ms\":%.3f,\"%s_cpu_ms\":%.3f", phaseKeys[i], stats->wallSeconds[i] * 1e3,
+                    phaseKeys[i], stats->cpuSeconds[i] * 1e3);
+        }
+        fprintf(stream, ",\"lines\":%ld,\"macro_expansions\":%ld,\"symbol_lookups\":%ld,\"fixups\":%ld,"
+                "\"code_words\":%ld,\"data_words\":%ld", stats->lines, stats->macroExpansions,
+                stats->symbolLookups, stats->fixups, stats->codeWords, stats->dataWords);
+        if (stats->trackAllocations) {
+            printAllocationStats(stream, stats, format);
+        }
+        fprintf(stream, "}\n");
+        return;
+    }
+
+    fprintf(stream, "Statistics for %s%s:\n", fileName, succeeded ? "" : " (failed)");
+    fprintf(stream, "  %-14s %10s %10s\n", "phase", "wall ms", "cpu ms");
+    for (int i = 0; i < NUM_OF_PHASES; i++) {
+        fprintf(stream, "  %-14s %10.3f %10.3f\n", phaseNames[i], stats->wallSeconds[i] * 1e3, stats->cpuSeconds[i] * 1e3);
+    }
+    fprintf(stream, "  lines %ld, macro expansions %ld, symbol lookups %ld, fixups %ld, code words %ld, data words %ld\n",
+            stats->lines, stats->macroExpansions, stats->symbolLookups, stats->fixups, stats->codeWords, stats->dataWords);
+    if (stats->trackAllocations) {
+        printAllocationStats(stream, stats, format);
+    }
+}
+
+// Parses the argument of --stats=FORMAT, returns 0 if the format is unknown
+int parseStatsFormat(const char *format) {
+    if (strcmp(format, "table") == 0) {
+        return STATS_TABLE;
+    }
+    if (strcmp(format, "json") == 0) {
+        return STATS_JSON;
+    }
+    return 0;
+}
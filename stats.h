@@ -0,0 +1,62 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include "allocator.h"
+
+// Phases timed by --stats
+#define PHASE_PRE 0       // Pre-assembler
+#define PHASE_FIRST 1     // First pass
+#define PHASE_SECOND 2    // Second pass, or the fixups in single-pass mode
+#define PHASE_OUTPUT 3    // Writing the output files
+#define PHASE_TOTAL 4     // The whole file, including the cache
+#define NUM_OF_PHASES 5
+
+// Report formats
+#define STATS_TABLE 1     // A table per file, for people
+#define STATS_JSON 2      // One JSON object per line and file, for dashboards
+
+// Times and counters of one file, collected when the context's stats is set
+typedef struct FileStats {
+    double wallSeconds[NUM_OF_PHASES];
+    double cpuSeconds[NUM_OF_PHASES];    // CPU time of the assembling thread
+    double wallStart[NUM_OF_PHASES];     // Start of each phase, while it runs
+    double cpuStart[NUM_OF_PHASES];
+    long lines;              // Source lines read by the pre-assembler
+    long macroExpansions;    // Macro invocations replaced by their content
+    long symbolLookups;      // Name lookups in the name pool
+    long fixups;             // Forward references patched after the first pass (single-pass mode)
+    long codeWords;
+    long dataWords;
+    int phase;               // The phase that runs, PHASE_TOTAL outside of the four others
+    int trackAllocations;    // 1 with --memory
+    AllocationCounters allocations[NUM_OF_ALLOC_KINDS];   // Per data structure
+    AllocationCounters phaseAllocations[NUM_OF_PHASES];  // Per phase, PHASE_TOTAL counts the rest
+    AllocationCounters totalAllocations;
+    long liveAtCleanup[NUM_OF_ALLOC_KINDS];              // Bytes each data structure held at the end
+    AllocationCounters arenaAllocations[NUM_OF_ALLOC_KINDS];  // Arena allocations per data structure,
+                                                              // live is the bytes still in the arena at the end
+} FileStats;
+
+// Starts and ends the timer of a phase. Without --stats the check is a single branch on the context
+#define startPhase(phase) \
+    do { \
+        if (context->stats != NULL) { \
+            startPhaseTimer(context->stats, phase); \
+        } \
+    } while (0)
+
+#define endPhase(phase) \
+    do { \
+        if (context->stats != NULL) { \
+            endPhaseTimer(context->stats, phase); \
+        } \
+    } while (0)
+
+void startPhaseTimer(FileStats *stats, int phase);
+void endPhaseTimer(FileStats *stats, int phase);
+void collectFileStats(FileStats *stats);
+void printFileStats(FILE *stream, const char *fileName, int succeeded, const FileStats *stats, int format);
+int parseStatsFormat(const char *format);
+
+#endif // STATS_H
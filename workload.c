@@ -0,0 +1,376 @@
+#define _DEFAULT_SOURCE  // wait4 is not part of POSIX
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include "workload.h"
+
+// The integer settings of a workload, by the name used on the command line
+static const struct {
+    const char *key;
+    size_t offset;
+} intSettings[] = {
+    {"labels", offsetof(WorkloadConfig, labelPercent)},
+    {"forward", offsetof(WorkloadConfig, forwardPercent)},
+    {"macros", offsetof(WorkloadConfig, macros)},
+    {"macro-lines", offsetof(WorkloadConfig, macroLines)},
+    {"macro-calls", offsetof(WorkloadConfig, macroCallPercent)},
+    {"data", offsetof(WorkloadConfig, dataPercent)},
+    {"data-values", offsetof(WorkloadConfig, dataValues)},
+    {"strings", offsetof(WorkloadConfig, stringPercent)},
+    {"string-length", offsetof(WorkloadConfig, stringLength)},
+    {"externs", offsetof(WorkloadConfig, externs)},
+    {"extern-refs", offsetof(WorkloadConfig, externRefPercent)},
+    {"entries", offsetof(WorkloadConfig, entries)},
+    {NULL, 0}
+};
+
+// State of the generator while it writes one file
+typedef struct Generator {
+    const WorkloadConfig *config;
+    FILE *stream;
+    unsigned long long random;  // xorshift64 state
+    long labelCount;            // Labels defined in the whole body
+    long nextLabel;             // Index of the next label to be defined
+} Generator;
+
+// Returns a pseudo-random number below 'limit' (xorshift64)
+static unsigned long nextRandom(Generator *generator, unsigned long limit) {
+    generator->random ^= generator->random << 13;
+    generator->random ^= generator->random >> 7;
+    generator->random ^= generator->random << 17;
+    return (unsigned long)(generator->random % limit);
+}
+
+// Fills 'operand' with an internal label, before or after the current line as configured.
+// Returns 0 if the workload has no labels
+static int labelOperand(Generator *generator, char *operand) {
+    long defined = generator->nextLabel;
+    long ahead = generator->labelCount - defined;
+    long label;
+
+    if (generator->labelCount == 0) {
+        return 0;
+    }
+    if (ahead > 0 && (defined == 0 || (int)nextRandom(generator, 100) < generator->config->forwardPercent)) {
+        label = defined + (long)nextRandom(generator, (unsigned long)ahead);
+    } else {
+        label = (long)nextRandom(generator, (unsigned long)defined);
+    }
+    sprintf(operand, "L%ld", label);
+    return 1;
+}
+
+// Fills 'operand' with a direct operand: an extern symbol or an internal label, or a register without labels
+static void directOperand(Generator *generator, char *operand) {
+    const WorkloadConfig *config = generator->config;
+
+    if (config->externs > 0 && (int)nextRandom(generator, 100) < config->externRefPercent) {
+        sprintf(operand, "X%lu", nextRandom(generator, (unsigned long)config->externs));
+    } else if (!labelOperand(generator, operand)) {
+        sprintf(operand, "r%lu", nextRandom(generator, 8));
+    }
+}
+
+// Fills 'operand' with a register or a direct operand (a target that can be written)
+static void writableOperand(Generator *generator, char *operand) {
+    if (nextRandom(generator, 2) == 0) {
+        sprintf(operand, "r%lu", nextRandom(generator, 8));
+    } else {
+        directOperand(generator, operand);
+    }
+}
+
+// Fills 'operand' with an immediate, register or direct operand
+static void sourceOperand(Generator *generator, char *operand) {
+    if (nextRandom(generator, 3) == 0) {
+        sprintf(operand, "#%ld", (long)nextRandom(generator, 201) - 100);
+    } else {
+        writableOperand(generator, operand);
+    }
+}
+
+// Writes one instruction with valid addressing modes, after the label prefix if any
+static void writeInstruction(Generator *generator, const char *prefix) {
+    static const char *singleOperand[] = {"clr", "not", "inc", "dec", "red"};
+    static const char *jumps[] = {"jmp", "bne", "jsr"};
+    static const char *arithmetic[] = {"mov", "add", "sub"};
+    char source[48], target[48];
+
+    switch (nextRandom(generator, 8)) {
+        case 0:
+        case 1:
+            sourceOperand(generator, source);
+            writableOperand(generator, target);
+            fprintf(generator->stream, "%s %s %s, %s\n", prefix, arithmetic[nextRandom(generator, 3)], source, target);
+            break;
+        case 2:
+            sourceOperand(generator, source);
+            sourceOperand(generator, target);
+            fprintf(generator->stream, "%s cmp %s, %s\n", prefix, source, target);
+            break;
+        case 3:
+            if (labelOperand(generator, source)) {
+                writableOperand(generator, target);
+                fprintf(generator->stream, "%s lea %s, %s\n", prefix, source, target);
+            } else {
+                fprintf(generator->stream, "%s rts\n", prefix);
+            }
+            break;
+        case 4:
+            writableOperand(generator, target);
+            fprintf(generator->stream, "%s %s %s\n", prefix, singleOperand[nextRandom(generator, 5)], target);
+            break;
+        case 5:
+            // Relative jumps only reach internal labels, direct ones may be external
+            if (generator->labelCount == 0 && generator->config->externs == 0) {
+                fprintf(generator->stream, "%s rts\n", prefix);  // Nothing to jump to
+                break;
+            }
+            if (nextRandom(generator, 2) == 0 && labelOperand(generator, target + 1)) {
+                target[0] = '&';
+            } else {
+                directOperand(generator, target);
+            }
+            fprintf(generator->stream, "%s %s %s\n", prefix, jumps[nextRandom(generator, 3)], target);
+            break;
+        case 6:
+            sourceOperand(generator, source);
+            fprintf(generator->stream, "%s prn %s\n", prefix, source);
+            break;
+        default:
+            fprintf(generator->stream, "%s rts\n", prefix);
+            break;
+    }
+}
+
+// Writes a .data line
+static void writeData(Generator *generator, const char *prefix) {
+    fprintf(generator->stream, "%s .data ", prefix);
+    for (int i = 0; i < generator->config->dataValues; i++) {
+        fprintf(generator->stream, i > 0 ? ", %ld" : "%ld", (long)nextRandom(generator, 2001) - 1000);
+    }
+    fputc('\n', generator->stream);
+}
+
+// Writes a .string line. The pre-assembler rejects any line containing "mcro" outside
+// a macro definition, so that sequence is never generated
+static void writeString(Generator *generator, const char *prefix) {
+    char previous[3] = {0, 0, 0};
+
+    fprintf(generator->stream, "%s .string \"", prefix);
+    for (int i = 0; i < generator->config->stringLength; i++) {
+        char letter = (char)('a' + (int)nextRandom(generator, 26));
+        if (letter == 'o' && previous[0] == 'm' && previous[1] == 'c' && previous[2] == 'r') {
+            letter = 'x';
+        }
+        previous[0] = previous[1];
+        previous[1] = previous[2];
+        previous[2] = letter;
+        fputc(letter, generator->stream);
+    }
+    fputs("\"\n", generator->stream);
+}
+
+// Sets the defaults: a mix of instructions and data, with some labels, macros and externs
+void defaultWorkloadConfig(WorkloadConfig *config, const char *name, long lines) {
+    memset(config, 0, sizeof(WorkloadConfig));
+    snprintf(config->name, sizeof(config->name), "%s", name);
+    config->lines = lines;
+    config->labelPercent = 20;
+    config->forwardPercent = 30;
+    config->macros = 10;
+    config->macroLines = 4;
+    config->macroCallPercent = 5;
+    config->dataPercent = 10;
+    config->dataValues = 4;
+    config->stringPercent = 5;
+    config->stringLength = 12;
+    config->externs = 10;
+    config->externRefPercent = 10;
+    config->entries = 10;
+    config->seed = 1;
+}
+
+/**
+ * @brief Applies one "key=value" setting, e.g. "lines=100000" or "forward=80".
+ *
+ * @return int 1 if the setting was applied, 0 for an unknown key or a bad value.
+ */
+int parseWorkloadSetting(WorkloadConfig *config, const char *setting) {
+    const char *equals = strchr(setting, '=');
+    char *end;
+
+    if (equals == NULL || equals[1] == '\0') {
+        return 0;
+    }
+    size_t keyLength = (size_t)(equals - setting);
+    long value = strtol(equals + 1, &end, 10);
+    if (*end != '\0' || value < 0) {
+        return 0;
+    }
+
+    if (keyLength == 5 && strncmp(setting, "lines", 5) == 0) {
+        config->lines = value;
+        return value > 0;
+    }
+    if (keyLength == 4 && strncmp(setting, "seed", 4) == 0) {
+        config->seed = (unsigned long)value;
+        return 1;
+    }
+    for (int i = 0; intSettings[i].key != NULL; i++) {
+        if (strlen(intSettings[i].key) == keyLength && strncmp(setting, intSettings[i].key, keyLength) == 0) {
+            *(int *)((char *)config + intSettings[i].offset) = (int)value;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Writes a valid .asm source with the shape of 'config'.
+ *
+ * The externs and entries come first, then the macro definitions, then the body.
+ * Labels are L0, L1, ... in order of definition, externs X0, X1, ... and macros M0, M1, ...
+ * Macro bodies only refer to labels, they never define one.
+ *
+ * @return long The number of lines written.
+ */
+long generateWorkload(const WorkloadConfig *config, FILE *stream) {
+    Generator generator;
+    char prefix[WORKLOAD_NAME_LENGTH];
+    long written = 0;
+    int macroLines = config->macroLines < MAX_MACRO_LINES ? config->macroLines : MAX_MACRO_LINES;
+
+    generator.config = config;
+    generator.stream = stream;
+    generator.random = 0x9E3779B97F4A7C15ULL ^ config->seed;
+    generator.labelCount = config->lines * config->labelPercent / 100;
+    generator.nextLabel = 0;
+
+    fprintf(stream, "; Generated workload '%s'\n", config->name);
+    written++;
+    for (int i = 0; i < config->externs; i++, written++) {
+        fprintf(stream, ".extern X%d\n", i);
+    }
+    long entries = config->entries < generator.labelCount ? config->entries : generator.labelCount;
+    for (long label = 0; label < generator.labelCount; label++) {
+        if (label * entries / generator.labelCount != (label + 1) * entries / generator.labelCount) {
+            fprintf(stream, ".entry L%ld\n", label);
+            written++;
+        }
+    }
+
+    for (int i = 0; i < config->macros; i++) {
+        fprintf(stream, "mcro M%d\n", i);
+        for (int j = 0; j < macroLines; j++) {
+            writeInstruction(&generator, "");
+        }
+        fprintf(stream, "mcroend\n");
+        written += macroLines + 2;
+    }
+
+    for (long i = 0; i < config->lines; i++, written++) {
+        int labeled = (i * config->labelPercent / 100) != ((i + 1) * config->labelPercent / 100);
+        int kind = (int)nextRandom(&generator, 100);
+
+        prefix[0] = '\0';
+        if (labeled) {
+            snprintf(prefix, sizeof(prefix), "L%ld:", generator.nextLabel++);
+        }
+
+        if (kind < config->dataPercent) {
+            writeData(&generator, prefix);
+        } else if (kind < config->dataPercent + config->stringPercent) {
+            writeString(&generator, prefix);
+        } else if (!labeled && config->macros > 0 &&
+                   kind < config->dataPercent + config->stringPercent + config->macroCallPercent) {
+            fprintf(stream, " M%lu\n", nextRandom(&generator, (unsigned long)config->macros));
+        } else {
+            writeInstruction(&generator, prefix);
+        }
+    }
+
+    fprintf(stream, " stop\n");
+    return written + 1;
+}
+
+// Writes <baseFile>.asm, returns 1 on success and the number of lines in sourceLines
+int writeWorkload(const WorkloadConfig *config, const char *baseFile, long *sourceLines) {
+    char fileName[256];
+
+    snprintf(fileName, sizeof(fileName), "%s.asm", baseFile);
+    FILE *stream = fopen(fileName, "w");
+    if (stream == NULL) {
+        printf("Error: Unable to create workload file: %s\n", fileName);
+        return 0;
+    }
+    *sourceLines = generateWorkload(config, stream);
+    if (fclose(stream) != 0) {
+        printf("Error: Unable to write workload file: %s\n", fileName);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Runs the assembler on <baseFile>.asm in a child process and measures it.
+ *
+ * The assembler's messages are discarded. The peak RSS and the CPU time come from
+ * the child's own resource usage, so they don't include the harness.
+ *
+ * @return int result->succeeded.
+ */
+int runAssembler(const char *assembler, const char *baseFile, RunResult *result) {
+    struct timespec start, end;
+    struct rusage usage;
+    int status;
+    char fileName[256];
+
+    memset(result, 0, sizeof(RunResult));
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        printf("Error: Unable to start %s\n", assembler);
+        return 0;
+    }
+    if (pid == 0) {
+        int devNull = open("/dev/null", O_WRONLY);
+        if (devNull >= 0) {
+            dup2(devNull, STDOUT_FILENO);
+            dup2(devNull, STDERR_FILENO);
+        }
+        execl(assembler, assembler, baseFile, (char *)NULL);
+        _exit(127);
+    }
+    if (wait4(pid, &status, 0, &usage) < 0) {
+        printf("Error: Lost the assembler process\n");
+        return 0;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    result->wallSeconds = (double)(end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    result->cpuSeconds = (double)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+                         (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+    result->peakKb = usage.ru_maxrss;  // Kilobytes on Linux
+    result->succeeded = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+    // The word count is the header line of the object file
+    snprintf(fileName, sizeof(fileName), "%s.ob", baseFile);
+    FILE *object = result->succeeded ? fopen(fileName, "r") : NULL;
+    if (object != NULL) {
+        long codeSize, dataSize;
+        if (fscanf(object, "%ld %ld", &codeSize, &dataSize) == 2) {
+            result->words = codeSize + dataSize;
+        }
+        fclose(object);
+    }
+    return result->succeeded;
+}
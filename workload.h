@@ -0,0 +1,43 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <stdio.h>
+
+#define WORKLOAD_NAME_LENGTH 32
+#define MAX_MACRO_LINES 60  // Macro content is limited to MAX * MAX characters
+
+// Shape of a generated .asm workload. Percentages are of the body lines
+typedef struct WorkloadConfig {
+    char name[WORKLOAD_NAME_LENGTH];
+    long lines;             // Body lines (instructions, data, strings and macro calls)
+    int labelPercent;       // Lines that define a label, spread evenly over the body
+    int forwardPercent;     // Label operands that refer to a label defined further down
+    int macros;             // Macros defined at the top of the file
+    int macroLines;         // Lines in each macro
+    int macroCallPercent;   // Lines that invoke a macro
+    int dataPercent;        // .data lines
+    int dataValues;         // Numbers in each .data line
+    int stringPercent;      // .string lines
+    int stringLength;       // Characters in each .string
+    int externs;            // .extern symbols declared
+    int externRefPercent;   // Direct operands that refer to an extern symbol
+    int entries;            // .entry lines, spread evenly over the labels
+    unsigned long seed;     // Seed of the generator, the same config always gives the same file
+} WorkloadConfig;
+
+// Measurements of one assembler run
+typedef struct RunResult {
+    double wallSeconds;     // Elapsed time
+    double cpuSeconds;      // User and system time of the assembler process
+    long peakKb;            // Peak resident set size of the assembler process
+    long words;             // Code and data words in the .ob file
+    int succeeded;          // 1 if the assembler exited with status 0
+} RunResult;
+
+void defaultWorkloadConfig(WorkloadConfig *config, const char *name, long lines);
+int parseWorkloadSetting(WorkloadConfig *config, const char *setting);
+long generateWorkload(const WorkloadConfig *config, FILE *stream);
+int writeWorkload(const WorkloadConfig *config, const char *baseFile, long *sourceLines);
+int runAssembler(const char *assembler, const char *baseFile, RunResult *result);
+
+#endif